@@ -6,6 +6,8 @@
 #include <string>
 #include <regex>
 #include <sstream>
+#include <charconv>
+#include <type_traits>
  
 #include <fmt/format.h>
 #include <fmt/ranges.h>
@@ -15,10 +17,22 @@
 namespace utils {
     template<typename T>
     T convert(const std::string& str) {
-        std::stringstream ss(str);
-        T val;
-        ss >> val;
-        return val;
+        if constexpr (std::is_arithmetic_v<T>) {
+            // tipos numéricos: std::from_chars, sem stringstream nem alocações;
+            // tal como 'ss >> val', ignora espaços iniciais e devolve 0 se falhar
+            auto inicio = str.find_first_not_of(" \t\n");
+            T val{};
+            if (inicio != std::string::npos) {
+                std::from_chars(str.data() + inicio, str.data() + str.size(), val);
+            }
+            return val;
+        }
+        else {
+            std::stringstream ss(str);
+            T val;
+            ss >> val;
+            return val;
+        }
     }
  
     inline std::vector<std::string> split(
@@ -93,6 +107,28 @@ namespace utils {
         return str2;
     }
  
+    /**
+     * Chave de pesquisa normalizada: maiúsculas, sem espaços nas pontas e com
+     * cada sequência de espaços/tabs/mudanças de linha reduzida a um espaço.
+     */
+    inline std::string normalize(const std::string& str) {
+        std::string norm;
+        norm.reserve(str.size());
+        bool espaco = false;
+        for (auto ch : str) {
+            if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+                espaco = !norm.empty();
+                continue;
+            }
+            if (espaco) {
+                norm.push_back(' ');
+                espaco = false;
+            }
+            norm.push_back(ch >= 'a' && ch <= 'z' ? char(ch - 32) : ch);
+        }
+        return norm;
+    }
+ 
     inline void _test() {
         #include <iostream>
         #include <fmt/format.h>
@@ -191,6 +227,10 @@ namespace utils {
  
         print("\n");
         print("utils::to_upper_copy(\"{}\") -> {}\n", str14, utils::to_upper_copy(str14));
+ 
+        print("\n");
+        print("utils::normalize(\"{}\") -> |{}|\n", str10, utils::normalize(str10));
+        print("utils::normalize(\"{}\") -> |{}|\n", str4a, utils::normalize(str4a));
     }
 }
  
@@ -0,0 +1,115 @@
+#ifndef __ASYNC_SAVE_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __ASYNC_SAVE_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <filesystem>
+#include <stdexcept>
+
+#include "vehicle_collection.hpp"
+
+namespace vehicle_collection {
+    /**
+     * Progresso de uma gravação em segundo plano.
+     */
+    struct SaveProgress {
+        std::size_t gravadas;
+        std::size_t total;
+
+        int percentagem() const {
+            return this->total == 0 ? 100 : int(100 * this->gravadas / this->total);
+        }
+    };
+
+    /**
+     * Grava snapshots de uma VehicleCollection em CSV numa thread própria,
+     * enquanto a coleção continua a ser alterada. Só é permitida uma
+     * gravação de cada vez. O ficheiro é primeiro escrito em '<path>.tmp' e
+     * depois renomeado, para que nunca fique meio gravado.
+     */
+    class AsyncSaver {
+    private:
+        std::thread worker;
+        std::atomic<bool> em_curso{false};
+        std::atomic<std::size_t> gravadas{0};
+        std::atomic<std::size_t> total{0};
+
+        mutable std::mutex mutex;
+        std::optional<std::string> erro;        // erro da última gravação
+
+    public:
+        AsyncSaver() = default;
+        AsyncSaver(const AsyncSaver&) = delete;
+        AsyncSaver& operator=(const AsyncSaver&) = delete;
+
+        ~AsyncSaver() {
+            this->wait();
+        }
+
+        /**
+         * Inicia a gravação de 'snapshot' em 'path'. Devolve false (sem fazer
+         * nada) se já houver uma gravação em curso.
+         */
+        bool start(VehicleCollection::Snapshot snapshot, const std::string& path) {
+            if (this->em_curso.exchange(true)) {
+                return false;
+            }
+            if (this->worker.joinable()) {
+                this->worker.join();
+            }
+
+            this->gravadas = 0;
+            this->total = snapshot->size();
+            {
+                std::lock_guard lock(this->mutex);
+                this->erro.reset();
+            }
+
+            this->worker = std::thread([this, snapshot = std::move(snapshot), path]() {
+                try {
+                    auto tmp = path + ".tmp";
+                    VehicleCollection::write_csv(*snapshot, tmp, [this](std::size_t n) {
+                        this->gravadas = n;
+                    });
+                    std::filesystem::rename(tmp, path);
+                }
+                catch (const std::exception& ex) {
+                    std::lock_guard lock(this->mutex);
+                    this->erro = ex.what();
+                }
+                this->em_curso = false;
+            });
+            return true;
+        }
+
+        bool busy() const {
+            return this->em_curso;
+        }
+
+        SaveProgress progress() const {
+            return {this->gravadas, this->total};
+        }
+
+        /**
+         * Espera que a gravação em curso (se existir) termine.
+         */
+        void wait() {
+            if (this->worker.joinable()) {
+                this->worker.join();
+            }
+        }
+
+        /**
+         * Erro da última gravação terminada, se tiver falhado.
+         */
+        std::optional<std::string> last_error() const {
+            std::lock_guard lock(this->mutex);
+            return this->erro;
+        }
+    };
+}
+
+#endif
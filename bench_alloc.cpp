@@ -0,0 +1,120 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <fmt/core.h>
+
+#include "Utils.hpp"
+#include "viatura.hpp"
+#include "vehicle_collection.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace vehicle_collection;
+
+/**
+ *  Contagem das alocações de memória feitas pelas pesquisas de
+ *  VehicleCollection: substitui o operator new global por um que conta as
+ *  chamadas e mostra a média de alocações por pesquisa.
+ *
+ *  bench_alloc [num_viaturas]
+ */
+static size_t num_alocacoes = 0;
+
+void* operator new(size_t tamanho) {
+    num_alocacoes += 1;
+    if (auto ptr = malloc(tamanho == 0 ? 1 : tamanho)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+// noinline: com free() inlined o GCC acusa (falsamente) -Wmismatched-new-delete
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+/**
+ *  Corre 'pesquisa' 'repeticoes' vezes e devolve a média de alocações.
+ */
+template<typename F>
+double alocacoes_por_pesquisa(size_t repeticoes, F pesquisa) {
+    auto inicio = num_alocacoes;
+    for (size_t i = 0; i < repeticoes; i += 1) {
+        pesquisa();
+    }
+    return double(num_alocacoes - inicio) / double(repeticoes);
+}
+
+void show_result(const string& descricao, double alocacoes) {
+    println("   {:<58} {:>10.1f}", descricao, alocacoes);
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_viaturas = 10'000;
+    if (argc > 1) {
+        if (!utils::is_digit(argv[1])) {
+            println("Uso: bench_alloc [num_viaturas]");
+            return 1;
+        }
+        num_viaturas = utils::convert<size_t>(argv[1]);
+    }
+    num_viaturas = min<size_t>(num_viaturas, 100 * 26 * 26 * 100);
+
+    const vector<string> marcas = {"Volkswagen", "Renault", "Peugeot", "Fiat", "Seat"};
+    const vector<string> modelos = {"Golf", "Clio", "208", "Punto", "Ibiza"};
+    VehicleCollection viaturas;
+    for (size_t i = 0; i < num_viaturas; i += 1) {
+        auto matricula = format(
+            "{:02}-{}{}-{:02}",
+            i % 100, char('A' + i / 100 % 26), char('A' + i / 2600 % 26), i / 67600 % 100
+        );
+        viaturas.emplace(
+            matricula,
+            marcas[i % marcas.size()],
+            modelos[i % modelos.size()],
+            format("20{:02}-{:02}-{:02}", i % 24, 1 + i % 12, 1 + i % 28)
+        );
+    }
+
+    const size_t REPETICOES = 100;
+    const string marca = "renault";                         // cabe no buffer SSO
+    const string marca_longa = "renault automobiles sa";    // não cabe no buffer SSO
+    const string matricula = "42-AB-00";
+    size_t encontradas = 0;
+
+    println("[+] {} viaturas, média de alocações por pesquisa:", viaturas.size());
+    show_result("search_by_marca (cópia das viaturas encontradas)", alocacoes_por_pesquisa(REPETICOES, [&]() {
+        encontradas += viaturas.search_by_marca(marca).size();
+    }));
+    show_result("for_each_by_marca", alocacoes_por_pesquisa(REPETICOES, [&]() {
+        viaturas.for_each_by_marca(marca, false, [&encontradas](const Viatura&) {
+            encontradas += 1;
+        });
+    }));
+    show_result(format("for_each_by_marca, termo com {} caracteres", marca_longa.size()),
+            alocacoes_por_pesquisa(REPETICOES, [&]() {
+        viaturas.for_each_by_marca(marca_longa, true, [&encontradas](const Viatura&) {
+            encontradas += 1;
+        });
+    }));
+    show_result("find_by_mat", alocacoes_por_pesquisa(REPETICOES, [&]() {
+        encontradas += viaturas.find_by_mat(matricula) != nullptr;
+    }));
+    show_result("percurso completo (for const&, get_marca/get_data)", alocacoes_por_pesquisa(REPETICOES, [&]() {
+        for (const auto& viat : viaturas) {
+            encontradas += viat.get_marca().size() == marca.size() && viat.get_data() < "2010";
+        }
+    }));
+    println("");
+    println("   for_each_by_marca só aloca para normalizar termos maiores que o buffer");
+    println("   SSO de std::string (15 caracteres em libstdc++).");
+    println("   ({} resultados)", encontradas);
+    return 0;
+}
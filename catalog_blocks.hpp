@@ -0,0 +1,400 @@
+#ifndef __CATALOG_BLOCKS_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __CATALOG_BLOCKS_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <fmt/format.h>
+
+#include "viatura.hpp"
+#include "vehicle_collection.hpp"
+
+/**
+ * Formato binário comprimido para catálogos de viaturas (.vcb).
+ *
+ *   "VCB1"
+ *   blocos          registos ordenados por matricula, BLOCK_SIZE por bloco
+ *   dicionário      nº de entradas + (comprimento, texto) de cada marca/modelo
+ *   directório      por bloco: offset, tamanho, nº de registos,
+ *                   matricula mín/máx e data mín/máx
+ *   rodapé          offset do dicionário (8 bytes) + "VCB1"
+ *
+ * Dentro de um bloco cada registo é guardado como: delta da matricula face
+ * ao registo anterior (a primeira face ao mínimo do bloco), id da marca e do
+ * modelo no dicionário e delta da data face à data mínima do bloco. Todos os
+ * inteiros são varints. O directório (cabeçalhos dos blocos) permite saltar
+ * blocos sem os descomprimir: uma pesquisa por matricula lê um único bloco.
+ */
+namespace vehicle_collection {
+    class InvalidFormat : public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    const std::string BLOCKS_MAGIC = "VCB1";
+    const std::size_t DEFAULT_BLOCK_SIZE = 1024;
+
+    struct BlockHeader {
+        std::uint64_t offset;
+        std::uint64_t tamanho;          // em bytes
+        std::uint32_t num_registos;
+        std::uint32_t min_mat;          // ver matricula_to_key()
+        std::uint32_t max_mat;
+        std::uint32_t min_data;         // ver data_to_int()
+        std::uint32_t max_data;
+    };
+
+    namespace blocks {
+        inline void put_varint(std::string& out, std::uint64_t valor) {
+            while (valor >= 0x80) {
+                out.push_back(char((valor & 0x7F) | 0x80));
+                valor >>= 7;
+            }
+            out.push_back(char(valor));
+        }
+
+        inline std::uint64_t get_varint(const std::string& in, std::size_t& pos) {
+            std::uint64_t valor = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos >= in.size()) {
+                    throw InvalidFormat("varint truncado");
+                }
+                auto byte = std::uint8_t(in[pos++]);
+                valor |= std::uint64_t(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return valor;
+                }
+            }
+            throw InvalidFormat("varint inválido");
+        }
+
+        inline void put_u64(std::string& out, std::uint64_t valor) {
+            for (int i = 0; i < 8; i += 1) {
+                out.push_back(char((valor >> (8 * i)) & 0xFF));
+            }
+        }
+
+        inline std::uint64_t get_u64(const std::string& in, std::size_t pos) {
+            std::uint64_t valor = 0;
+            for (int i = 0; i < 8; i += 1) {
+                valor |= std::uint64_t(std::uint8_t(in[pos + i])) << (8 * i);
+            }
+            return valor;
+        }
+
+        inline std::string read_at(std::ifstream& file, std::uint64_t offset, std::size_t tamanho) {
+            std::string buffer(tamanho, '\0');
+            file.seekg(std::streamoff(offset));
+            if (!file.read(buffer.data(), std::streamsize(tamanho))) {
+                throw InvalidFormat("ficheiro truncado");
+            }
+            return buffer;
+        }
+    }
+
+    /**
+     * Grava a coleção no formato por blocos (ver comentário no topo do ficheiro).
+     */
+    inline void to_blocks(
+            const VehicleCollection& viaturas,
+            const std::string& path,
+            std::size_t block_size = DEFAULT_BLOCK_SIZE
+    ) {
+        if (block_size == 0) {
+            throw std::invalid_argument("to_blocks: tamanho de bloco inválido");
+        }
+        // ordenação local (ordered() deixaria uma permutação na coleção, a
+        // manter em cada add()/delete_() seguinte)
+        std::vector<const Viatura*> ordenadas;
+        ordenadas.reserve(viaturas.size());
+        for (const auto& viat : viaturas) {
+            ordenadas.push_back(&viat);
+        }
+        std::sort(ordenadas.begin(), ordenadas.end(), [](const Viatura* a, const Viatura* b) {
+            return a->get_matricula() < b->get_matricula();
+        });
+
+        // dicionário comum a marcas e modelos
+        std::vector<std::string> dicionario;
+        std::unordered_map<std::string, std::uint64_t> ids;
+        auto id_de = [&dicionario, &ids](const std::string& texto) {
+            auto [it, novo] = ids.try_emplace(texto, dicionario.size());
+            if (novo) {
+                dicionario.push_back(texto);
+            }
+            return it->second;
+        };
+
+        std::string out = BLOCKS_MAGIC;
+        std::vector<BlockHeader> directorio;
+        for (std::size_t inicio = 0; inicio < ordenadas.size(); inicio += block_size) {
+            auto fim = std::min(inicio + block_size, ordenadas.size());
+
+            BlockHeader header{};
+            header.offset = out.size();
+            header.num_registos = std::uint32_t(fim - inicio);
+            header.min_mat = matricula_to_key(ordenadas[inicio]->get_matricula());
+            header.max_mat = matricula_to_key(ordenadas[fim - 1]->get_matricula());
+            header.min_data = UINT32_MAX;
+            header.max_data = 0;
+            for (auto i = inicio; i < fim; i += 1) {
+                auto data = data_to_int(ordenadas[i]->get_data());
+                header.min_data = std::min(header.min_data, data);
+                header.max_data = std::max(header.max_data, data);
+            }
+
+            auto anterior = header.min_mat;
+            for (auto i = inicio; i < fim; i += 1) {
+                const auto& viat = *ordenadas[i];
+                auto mat = matricula_to_key(viat.get_matricula());
+                blocks::put_varint(out, mat - anterior);
+                blocks::put_varint(out, id_de(viat.get_marca()));
+                blocks::put_varint(out, id_de(viat.get_modelo()));
+                blocks::put_varint(out, data_to_int(viat.get_data()) - header.min_data);
+                anterior = mat;
+            }
+            header.tamanho = out.size() - header.offset;
+            directorio.push_back(header);
+        }
+
+        auto offset_dicionario = out.size();
+        blocks::put_varint(out, dicionario.size());
+        for (const auto& texto : dicionario) {
+            blocks::put_varint(out, texto.size());
+            out += texto;
+        }
+
+        blocks::put_varint(out, directorio.size());
+        for (const auto& header : directorio) {
+            blocks::put_varint(out, header.offset);
+            blocks::put_varint(out, header.tamanho);
+            blocks::put_varint(out, header.num_registos);
+            blocks::put_varint(out, header.min_mat);
+            blocks::put_varint(out, header.max_mat - header.min_mat);
+            blocks::put_varint(out, header.min_data);
+            blocks::put_varint(out, header.max_data - header.min_data);
+        }
+
+        blocks::put_u64(out, offset_dicionario);
+        out += BLOCKS_MAGIC;
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(out.data(), std::streamsize(out.size()));
+        if (!file) {
+            throw std::runtime_error(fmt::format("Erro ao gravar {}", path));
+        }
+    }
+
+    /**
+     * Leitor de catálogos no formato por blocos. Na abertura só são lidos o
+     * dicionário e o directório; os blocos são lidos e descomprimidos apenas
+     * quando uma pesquisa precisa deles.
+     */
+    class CatalogReader {
+    private:
+        mutable std::ifstream file;
+        std::vector<std::string> dicionario;
+        std::vector<BlockHeader> directorio;
+        mutable std::size_t blocos_lidos_ = 0;
+
+        /**
+         * Descomprime o bloco 'b', chamando 'funcao(mat, marca_id, modelo_id, data)'
+         * para cada registo até que esta devolva false.
+         */
+        template<typename F>
+        void decode_block(std::size_t b, F funcao) const {
+            const auto& header = this->directorio[b];
+            auto bloco = blocks::read_at(this->file, header.offset, std::size_t(header.tamanho));
+            this->blocos_lidos_ += 1;
+
+            std::size_t pos = 0;
+            auto mat = header.min_mat;
+            for (std::uint32_t i = 0; i < header.num_registos; i += 1) {
+                mat += std::uint32_t(blocks::get_varint(bloco, pos));
+                auto marca = blocks::get_varint(bloco, pos);
+                auto modelo = blocks::get_varint(bloco, pos);
+                auto data = header.min_data + std::uint32_t(blocks::get_varint(bloco, pos));
+                if (marca >= this->dicionario.size() || modelo >= this->dicionario.size()) {
+                    throw InvalidFormat("id de dicionário inválido");
+                }
+                if (!funcao(mat, marca, modelo, data)) {
+                    return;
+                }
+            }
+        }
+
+        Viatura make_viatura(
+                std::uint32_t mat,
+                std::uint64_t marca,
+                std::uint64_t modelo,
+                std::uint32_t data
+        ) const {
+            return Viatura(
+                key_to_matricula(mat),
+                this->dicionario[marca],
+                this->dicionario[modelo],
+                int_to_data(data)
+            );
+        }
+
+    public:
+        explicit CatalogReader(const std::string& path)
+            : file(path, std::ios::binary)
+        {
+            if (!this->file) {
+                throw std::runtime_error(fmt::format("Erro ao abrir {}", path));
+            }
+            this->file.seekg(0, std::ios::end);
+            auto tamanho = std::uint64_t(this->file.tellg());
+            const auto tamanho_rodape = 8 + BLOCKS_MAGIC.size();
+            if (tamanho < BLOCKS_MAGIC.size() + tamanho_rodape
+                    || blocks::read_at(this->file, 0, BLOCKS_MAGIC.size()) != BLOCKS_MAGIC) {
+                throw InvalidFormat(fmt::format("{} não é um catálogo por blocos", path));
+            }
+            auto rodape = blocks::read_at(this->file, tamanho - tamanho_rodape, tamanho_rodape);
+            if (rodape.substr(8) != BLOCKS_MAGIC) {
+                throw InvalidFormat(fmt::format("{}: rodapé inválido", path));
+            }
+
+            auto offset_dicionario = blocks::get_u64(rodape, 0);
+            if (offset_dicionario > tamanho - tamanho_rodape) {
+                throw InvalidFormat(fmt::format("{}: offset do dicionário inválido", path));
+            }
+            auto meta = blocks::read_at(
+                this->file, offset_dicionario,
+                std::size_t(tamanho - tamanho_rodape - offset_dicionario)
+            );
+
+            std::size_t pos = 0;
+            auto num_entradas = blocks::get_varint(meta, pos);
+            for (std::uint64_t i = 0; i < num_entradas; i += 1) {
+                auto len = std::size_t(blocks::get_varint(meta, pos));
+                if (pos + len > meta.size()) {
+                    throw InvalidFormat("dicionário truncado");
+                }
+                this->dicionario.push_back(meta.substr(pos, len));
+                pos += len;
+            }
+
+            auto num_blocos = blocks::get_varint(meta, pos);
+            for (std::uint64_t i = 0; i < num_blocos; i += 1) {
+                BlockHeader header{};
+                header.offset = blocks::get_varint(meta, pos);
+                header.tamanho = blocks::get_varint(meta, pos);
+                header.num_registos = std::uint32_t(blocks::get_varint(meta, pos));
+                header.min_mat = std::uint32_t(blocks::get_varint(meta, pos));
+                header.max_mat = header.min_mat + std::uint32_t(blocks::get_varint(meta, pos));
+                header.min_data = std::uint32_t(blocks::get_varint(meta, pos));
+                header.max_data = header.min_data + std::uint32_t(blocks::get_varint(meta, pos));
+                if (header.offset + header.tamanho > offset_dicionario) {
+                    throw InvalidFormat("directório inválido");
+                }
+                this->directorio.push_back(header);
+            }
+        }
+
+        const std::vector<BlockHeader>& headers() const {
+            return this->directorio;
+        }
+
+        std::size_t size() const {
+            std::size_t total = 0;
+            for (const auto& header : this->directorio) {
+                total += header.num_registos;
+            }
+            return total;
+        }
+
+        /**
+         * Número de blocos descomprimidos desde a abertura (estatística).
+         */
+        std::size_t blocos_lidos() const {
+            return this->blocos_lidos_;
+        }
+
+        /**
+         * Pesquisa por matricula: localiza o bloco pelo directório e
+         * descomprime apenas esse bloco.
+         */
+        std::optional<Viatura> search_by_mat(const std::string& matricula) const {
+            if (!Viatura::valida_matricula(matricula)) {
+                return {};
+            }
+            auto chave = matricula_to_key(matricula);
+            auto it = std::lower_bound(
+                this->directorio.begin(), this->directorio.end(), chave,
+                [](const BlockHeader& header, std::uint32_t valor) {
+                    return header.max_mat < valor;
+                }
+            );
+            if (it == this->directorio.end() || it->min_mat > chave) {
+                return {};
+            }
+
+            std::optional<Viatura> encontrada;
+            this->decode_block(std::size_t(it - this->directorio.begin()),
+                [this, chave, &encontrada](auto mat, auto marca, auto modelo, auto data) {
+                    if (mat == chave) {
+                        encontrada = this->make_viatura(mat, marca, modelo, data);
+                    }
+                    return mat < chave;
+                }
+            );
+            return encontrada;
+        }
+
+        /**
+         * Pesquisa por intervalo de datas (inclusive, formato ISO). Os blocos
+         * cujo intervalo de datas não intersecta o pedido não são lidos.
+         */
+        VehicleCollection search_by_data(const std::string& de, const std::string& ate) const {
+            if (!Viatura::valida_data(de) || !Viatura::valida_data(ate)) {
+                throw InvalidAttr(fmt::format("Intervalo de datas {} - {} inválido", de, ate));
+            }
+            auto min_data = data_to_int(de);
+            auto max_data = data_to_int(ate);
+
+            VehicleCollection found_viaturas;
+            for (std::size_t b = 0; b < this->directorio.size(); b += 1) {
+                const auto& header = this->directorio[b];
+                if (header.max_data < min_data || header.min_data > max_data) {
+                    continue;
+                }
+                this->decode_block(b, [&](auto mat, auto marca, auto modelo, auto data) {
+                    if (data >= min_data && data <= max_data) {
+                        found_viaturas.add(this->make_viatura(mat, marca, modelo, data));
+                    }
+                    return true;
+                });
+            }
+            return found_viaturas;
+        }
+
+        /**
+         * Descomprime todo o catálogo para uma VehicleCollection.
+         */
+        VehicleCollection load() const {
+            VehicleCollection viaturas;
+            for (std::size_t b = 0; b < this->directorio.size(); b += 1) {
+                this->decode_block(b, [&](auto mat, auto marca, auto modelo, auto data) {
+                    viaturas.add(this->make_viatura(mat, marca, modelo, data));
+                    return true;
+                });
+            }
+            return viaturas;
+        }
+    };
+
+    /**
+     * Lê um catálogo gravado com to_blocks() (equivalente a VehicleCollection::from_csv).
+     */
+    inline VehicleCollection from_blocks(const std::string& path) {
+        return CatalogReader(path).load();
+    }
+}
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef __EXTERNAL_MERGE_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __EXTERNAL_MERGE_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <filesystem>
+#include <charconv>
+#include <random>
+#include <cstdint>
+#include <fmt/format.h>
+
+#include "viatura.hpp"
+#include "vehicle_collection.hpp"
+
+/**
+ * Fusão de vários catálogos CSV, eventualmente maiores que a memória, num
+ * único catálogo sem matriculas repetidas (ordenação externa):
+ *
+ *   1. cada ficheiro de entrada é lido sequencialmente e validado por Viatura;
+ *   2. os registos válidos acumulam-se num buffer de tamanho limitado que,
+ *      quando cheio, é ordenado por matricula e gravado num ficheiro
+ *      temporário (run);
+ *   3. os runs são fundidos (k-way merge) e, para cada matricula, fica apenas
+ *      o registo escolhido pela política de duplicados.
+ *
+ * Nos runs cada linha é "seq|<viatura em CSV>", onde 'seq' é a ordem global
+ * do registo nas entradas (usada pelas políticas PRIMEIRO/ULTIMO e como
+ * desempate). Os runs ficam numa subdiretoria própria de cada fusão, criada
+ * em tmp_dir, para que fusões em simultâneo não partilhem ficheiros.
+ */
+namespace vehicle_collection {
+    /**
+     * Política de resolução de matriculas duplicadas.
+     */
+    enum class MergePolicy {
+        MAIS_RECENTE,       // fica o registo com a data mais recente (empate: o último)
+        PRIMEIRO,           // fica o primeiro registo lido
+        ULTIMO              // fica o último registo lido
+    };
+
+    struct MergeOptions {
+        MergePolicy politica = MergePolicy::MAIS_RECENTE;
+        std::size_t max_registos = 1'000'000;       // registos em memória por run
+        std::size_t max_runs_abertos = 64;          // fan-in máximo de cada fusão
+        std::filesystem::path tmp_dir = std::filesystem::temp_directory_path();
+    };
+
+    struct MergeStats {
+        std::size_t lidas = 0;              // linhas de dados lidas das entradas
+        std::size_t rejeitadas = 0;         // linhas inválidas
+        std::size_t duplicadas = 0;         // registos descartados pela política
+        std::size_t escritas = 0;           // registos no catálogo final
+        std::size_t runs = 0;               // runs temporários gravados
+    };
+
+    class ExternalMerge {
+    private:
+        struct Registo {
+            std::uint64_t seq;
+            Viatura viat;
+        };
+
+        /**
+         * Leitor sequencial de um run.
+         */
+        struct RunReader {
+            std::ifstream file;
+            std::optional<Registo> atual;
+
+            explicit RunReader(const std::filesystem::path& path) : file(path) {
+                this->next();
+            }
+
+            void next() {
+                this->atual.reset();
+                std::string line;
+                if (!std::getline(this->file, line)) {
+                    return;
+                }
+                auto sep = line.find(CSV_DELIM);
+                std::uint64_t seq = 0;
+                std::optional<Viatura> viat;
+                if (sep == std::string::npos
+                        || std::from_chars(line.data(), line.data() + sep, seq).ec != std::errc()
+                        || Viatura::try_from_csv(std::string_view(line).substr(sep + CSV_DELIM.size()), viat) != ParseStatus::OK) {
+                    throw InvalidAttr(fmt::format("Run temporário corrompido: {}", line));
+                }
+                this->atual.emplace(Registo{seq, std::move(*viat)});
+            }
+        };
+
+        MergeOptions opcoes;
+        MergeStats stats;
+        std::filesystem::path run_dir;      // vazio até ao primeiro run
+        std::size_t proximo_run = 0;
+
+        /**
+         * true se 'novo' deve substituir 'atual' (mesma matricula). As três
+         * políticas escolhem o máximo de uma chave, logo o resultado não
+         * depende da ordem em que os duplicados são encontrados.
+         */
+        bool substitui(const Registo& atual, const Registo& novo) const {
+            switch (this->opcoes.politica) {
+                case MergePolicy::PRIMEIRO:
+                    return novo.seq < atual.seq;
+                case MergePolicy::ULTIMO:
+                    return novo.seq > atual.seq;
+                case MergePolicy::MAIS_RECENTE:
+                default:
+                    return std::tie(novo.viat.get_data(), novo.seq)
+                         > std::tie(atual.viat.get_data(), atual.seq);
+            }
+        }
+
+        /**
+         * Caminho para um novo run. Na primeira chamada cria a subdiretoria
+         * da fusão com um nome aleatório; create_directory falha se o nome
+         * já existir, logo nenhuma outra fusão (ou processo) a usa.
+         */
+        std::filesystem::path novo_temporario() {
+            if (this->run_dir.empty()) {
+                std::random_device aleatorio;
+                std::filesystem::path dir;
+                do {
+                    dir = this->opcoes.tmp_dir / fmt::format(
+                        "viaturas_merge_{:08x}{:08x}", aleatorio(), aleatorio()
+                    );
+                } while (!std::filesystem::create_directory(dir));
+                this->run_dir = dir;
+            }
+            return this->run_dir / fmt::format("{}.run", this->proximo_run++);
+        }
+
+        static void write_registo(std::ofstream& out, const Registo& reg) {
+            out << reg.seq << CSV_DELIM << reg.viat.to_csv() << '\n';
+        }
+
+        /**
+         * Fecha 'out' e lança uma excepção se alguma escrita tiver falhado
+         * (ex: disco cheio), incluindo as que só acontecem ao esvaziar o buffer.
+         */
+        static void fecha(std::ofstream& out, const std::filesystem::path& path) {
+            out.close();
+            if (!out) {
+                throw std::runtime_error(fmt::format("Erro ao gravar {}", path.string()));
+            }
+        }
+
+        /**
+         * Ordena o buffer por matricula, resolve duplicados e grava-o num run.
+         */
+        void spill(std::vector<Registo>& buffer, std::vector<std::filesystem::path>& runs) {
+            if (buffer.empty()) {
+                return;
+            }
+            std::sort(buffer.begin(), buffer.end(), [](const Registo& a, const Registo& b) {
+                return std::tie(a.viat.get_matricula(), a.seq) < std::tie(b.viat.get_matricula(), b.seq);
+            });
+
+            auto path = this->novo_temporario();
+            std::ofstream out(path);
+            std::size_t melhor = 0;
+            for (std::size_t i = 1; i <= buffer.size(); i += 1) {
+                if (i < buffer.size() && buffer[i].viat.get_matricula() == buffer[melhor].viat.get_matricula()) {
+                    this->stats.duplicadas += 1;
+                    if (this->substitui(buffer[melhor], buffer[i])) {
+                        melhor = i;
+                    }
+                    continue;
+                }
+                write_registo(out, buffer[melhor]);
+                melhor = i;
+            }
+            fecha(out, path);
+
+            runs.push_back(path);
+            this->stats.runs += 1;
+            buffer.clear();
+        }
+
+        /**
+         * Funde os runs indicados (k-way merge), chamando 'escreve' uma vez por
+         * matricula com o registo escolhido pela política.
+         */
+        template<typename F>
+        void merge_runs(const std::vector<std::filesystem::path>& runs, F escreve) {
+            std::vector<std::unique_ptr<RunReader>> leitores;
+            for (const auto& path : runs) {
+                leitores.emplace_back(std::make_unique<RunReader>(path));
+            }
+
+            auto maior = [&leitores](std::size_t a, std::size_t b) {
+                const auto& ra = *leitores[a]->atual;
+                const auto& rb = *leitores[b]->atual;
+                return std::tie(ra.viat.get_matricula(), ra.seq) > std::tie(rb.viat.get_matricula(), rb.seq);
+            };
+            std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(maior)> heap(maior);
+            for (std::size_t i = 0; i < leitores.size(); i += 1) {
+                if (leitores[i]->atual) {
+                    heap.push(i);
+                }
+            }
+
+            std::optional<Registo> melhor;
+            while (!heap.empty()) {
+                auto i = heap.top();
+                heap.pop();
+                auto& reg = *leitores[i]->atual;
+
+                if (melhor && melhor->viat.get_matricula() == reg.viat.get_matricula()) {
+                    this->stats.duplicadas += 1;
+                    if (this->substitui(*melhor, reg)) {
+                        melhor.emplace(std::move(reg));
+                    }
+                }
+                else {
+                    if (melhor) {
+                        escreve(*melhor);
+                    }
+                    melhor.emplace(std::move(reg));
+                }
+
+                leitores[i]->next();
+                if (leitores[i]->atual) {
+                    heap.push(i);
+                }
+            }
+            if (melhor) {
+                escreve(*melhor);
+            }
+        }
+
+        void remove_temporarios() {
+            if (!this->run_dir.empty()) {
+                std::error_code ec;
+                std::filesystem::remove_all(this->run_dir, ec);
+                this->run_dir.clear();
+            }
+        }
+
+    public:
+        explicit ExternalMerge(MergeOptions opcoes = MergeOptions()) : opcoes(std::move(opcoes)) {
+            if (this->opcoes.max_registos == 0 || this->opcoes.max_runs_abertos < 2) {
+                throw std::invalid_argument("ExternalMerge: opções inválidas");
+            }
+        }
+
+        ExternalMerge(const ExternalMerge&) = delete;
+        ExternalMerge& operator=(const ExternalMerge&) = delete;
+
+        ~ExternalMerge() {
+            this->remove_temporarios();
+        }
+
+        /**
+         * Funde os catálogos 'entradas' no catálogo 'saida' (formato de
+         * VehicleCollection::to_csv, ordenado por matricula). Linhas inválidas
+         * são ignoradas e contadas em MergeStats::rejeitadas.
+         */
+        MergeStats merge(const std::vector<std::string>& entradas, const std::string& saida) {
+            this->stats = MergeStats();
+
+            // 1 e 2: leitura, validação e gravação dos runs ordenados
+            std::vector<std::filesystem::path> runs;
+            std::vector<Registo> buffer;
+            buffer.reserve(this->opcoes.max_registos);
+            std::uint64_t seq = 0;
+            for (const auto& entrada : entradas) {
+                std::ifstream csv_file(entrada);
+                if (!csv_file) {
+                    throw std::runtime_error(fmt::format("Erro ao abrir {}", entrada));
+                }
+                std::string line;
+                std::optional<Viatura> viat;
+                while (std::getline(csv_file, line)) {
+                    if (VehicleCollection::linha_ignorada(line)) {
+                        continue;
+                    }
+                    this->stats.lidas += 1;
+
+                    viat.reset();
+                    if (Viatura::try_from_csv(line, viat) != ParseStatus::OK) {
+                        this->stats.rejeitadas += 1;
+                        continue;
+                    }
+                    buffer.push_back({seq++, std::move(*viat)});
+                    if (buffer.size() >= this->opcoes.max_registos) {
+                        this->spill(buffer, runs);
+                    }
+                }
+            }
+            this->spill(buffer, runs);
+            buffer.shrink_to_fit();
+
+            // 3a: enquanto houver demasiados runs, funde-os em grupos
+            while (runs.size() > this->opcoes.max_runs_abertos) {
+                std::vector<std::filesystem::path> fundidos;
+                for (std::size_t i = 0; i < runs.size(); i += this->opcoes.max_runs_abertos) {
+                    auto fim = std::min(i + this->opcoes.max_runs_abertos, runs.size());
+                    std::vector<std::filesystem::path> grupo(runs.begin() + i, runs.begin() + fim);
+
+                    auto path = this->novo_temporario();
+                    std::ofstream out(path);
+                    this->merge_runs(grupo, [&out](const Registo& reg) {
+                        write_registo(out, reg);
+                    });
+                    fecha(out, path);
+
+                    // os runs do grupo só são apagados depois de o run
+                    // fundido estar completamente gravado
+                    fundidos.push_back(path);
+                    for (const auto& usado : grupo) {
+                        std::error_code ec;
+                        std::filesystem::remove(usado, ec);
+                    }
+                }
+                runs = std::move(fundidos);
+            }
+
+            // 3b: fusão final para o catálogo de saída
+            std::ofstream out(saida);
+            if (!out) {
+                throw std::runtime_error(fmt::format("Erro ao gravar {}", saida));
+            }
+            this->merge_runs(runs, [this, &out](const Registo& reg) {
+                if (this->stats.escritas > 0) {
+                    out << '\n';
+                }
+                out << reg.viat.to_csv();
+                this->stats.escritas += 1;
+            });
+            fecha(out, saida);
+
+            this->remove_temporarios();
+            return this->stats;
+        }
+    };
+}
+
+#endif
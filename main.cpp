@@ -10,10 +10,13 @@
 #include <fmt/ranges.h>
 #include <fmt/core.h>
 #include <cstdlib>
+#include <chrono>
+#include <thread>
 
 #include "Utils.hpp"
 #include "viatura.hpp"
 #include "vehicle_collection.hpp"
+#include "async_save.hpp"
  
 using namespace std;
 using namespace fmt;
@@ -23,7 +26,9 @@ using namespace vehicle_collection;
  *  Variáveis globais
  */ 
 VehicleCollection viaturas; 
+AsyncSaver gravacao;        // gravação do catálogo em segundo plano
 const int DEFAULT_INDENTATION = 3;
+const string CATALOG_PATH = "viaturas.csv";
  
 /**
  * Função para exibir mesagens na consola com identação padrão ou customizada.
@@ -75,10 +80,9 @@ void pause_(int indent = 3) {
  
 
 /**
- *  Função que define e exibe em formato de tabela
- *  todas as viaturas da coleção.
+ *  Função que exibe o cabeçalho da tabela de viaturas.
  */
-void show_table_with_viats(VehicleCollection& viaturas) {
+void show_table_header() {
     auto header = format(
         "{:^16} | {:^20} | {:^20} | {:^16}",
         "MATRICULA", "MARCA", "MODELO", "DATA"
@@ -90,18 +94,46 @@ void show_table_with_viats(VehicleCollection& viaturas) {
    
     show_msg(header);
     show_msg(sep);
+}
+
+/**
+ *  Função que exibe uma viatura como linha da tabela.
+ */
+void show_table_line(const Viatura& viat) {
+    auto data_line = format(
+        "{:<16} | {:<20} | {:<20} | {:>16}",
+        viat.get_matricula(),
+        viat.get_marca(),
+        viat.get_modelo(),
+        viat.get_data()
+       
+    );
+    show_msg(data_line);
+}
+
+/**
+ *  Função que define e exibe em formato de tabela
+ *  todas as viaturas da coleção.
+ */
+void show_table_with_viats(const VehicleCollection& viaturas) {
+    show_table_header();
  
     for (const auto& viat : viaturas) {
-        auto data_line = format(
-            "{:<16} | {:<20} | {:<20} | {:>16}",
-            viat.get_matricula(),
-            viat.get_marca(),
-            viat.get_modelo(),
-            viat.get_data()
-           
-        );
-        show_msg(data_line);
-        
+        show_table_line(viat);
+    }
+ 
+    pause_();
+}
+
+/**
+ *  Função que exibe em formato de tabela uma listagem ordenada
+ *  (ponteiros para viaturas da coleção, pela ordem a mostrar).
+ */
+void show_table_with_viats(const vector<const Viatura*>& ordenadas) {
+    show_table_header();
+ 
+    for (const auto* viat : ordenadas) {
+        show_table_line(*viat);
     }
  
     pause_();
@@ -127,6 +159,34 @@ void exec_list_viats() {
     //pause_();
 }
 
+/**
+ *  Função que lista todas as viaturas ordenadas por marca e modelo.
+ */
+void exec_list_viats_by_marca() {
+    clear_screen();
+    println("");
+    show_table_with_viats(viaturas.ordered(SortKey::MARCA_MODELO));
+}
+
+/**
+ *  Função que lista as N viaturas mais recentes (por data).
+ */
+void exec_list_most_recent() {
+    clear_screen();
+    println("");
+ 
+    show_msg("VIATURAS MAIS RECENTES\n");
+    auto quantas = ask("Indique quantas viaturas pretende listar: ");
+    println("");
+ 
+    if (!utils::is_digit(quantas)) {
+        show_msg(format("Quantidade {} inválida", quantas));
+        pause_();
+        return;
+    }
+    show_table_with_viats(viaturas.top_k(SortKey::DATA, utils::convert<size_t>(quantas), true));
+}
+
 /**
  *  Função para pesquisa na coleção de uma viatura pela matricula
  */
@@ -138,21 +198,29 @@ void exec_search_by_matricula() {
     auto matricula = ask("Indique a matricula das viaturas a pesquisar: ");
     println("");
  
-    auto encontrados = viaturas.search([matricula](const Viatura& viat) {
-        return viat.get_matricula() == matricula;
-        }
-    );
-    if (encontrados.empty()) {
+    auto encontrada = viaturas.find_by_mat(matricula);
+    if (!encontrada) {
         show_msg(format("Não foram encontrados viaturas deste modelo {}", matricula));
     }
     else {
-        show_table_with_viats(encontrados);
+        show_table_with_viats(vector<const Viatura*>{encontrada});
     }
  
     println("");
     
 }
 
+/**
+ *  Função que interpreta um termo de pesquisa: um '*' final indica
+ *  pesquisa por prefixo. Devolve o termo sem o '*' e se é prefixo.
+ */
+pair<string, bool> search_term(const string& termo) {
+    if (!termo.empty() && termo.back() == '*') {
+        return {termo.substr(0, termo.size() - 1), true};
+    }
+    return {termo, false};
+}
+
 /**
  *  Função para pesquisa na coleção de uma viatura pela marca
  */
@@ -161,14 +229,14 @@ void exec_search_by_marca(){
     println("");
  
     show_msg("PESQUISA POR MARCA\n");
-    auto marca = ask("Indique a marca das viaturas a pesquisar: ");
+    auto marca = ask("Indique a marca das viaturas a pesquisar (termine com * para prefixo): ");
     println("");
    
-    auto por_marca = [marca](const Viatura& viat) {
-        return viat.get_marca() == marca;
-    };
- 
-    auto encontrados = viaturas.search(por_marca);
+    auto [termo, prefixo] = search_term(marca);
+    vector<const Viatura*> encontrados;
+    viaturas.for_each_by_marca(termo, prefixo, [&encontrados](const Viatura& viat) {
+        encontrados.push_back(&viat);
+    });
     if (encontrados.empty()) {
         show_msg(format("Não foram encontrados viaturas com essa marca {}", marca));
         pause_();
@@ -187,13 +255,14 @@ void exec_search_by_modelo() {
     println("");
  
     show_msg("PESQUISA POR MODELO\n");
-    auto modelo = ask("Indique o modelo das viaturas a pesquisar: ");
+    auto modelo = ask("Indique o modelo das viaturas a pesquisar (termine com * para prefixo): ");
     println("");
  
-    auto encontrados = viaturas.search([modelo](const Viatura& viat) {
-        return viat.get_modelo() == modelo;
-        }
-    );
+    auto [termo, prefixo] = search_term(modelo);
+    vector<const Viatura*> encontrados;
+    viaturas.for_each_by_modelo(termo, prefixo, [&encontrados](const Viatura& viat) {
+        encontrados.push_back(&viat);
+    });
     if (encontrados.empty()) {
         show_msg(format("Não foram encontrados viaturas deste modelo {}", modelo));
     }
@@ -257,8 +326,7 @@ void acresc_viatura(){
         println("   Data {} inválida", data);
     }
    
-    Viatura novaViatura(matricula,marca,modelo,data);
-    viaturas.add(novaViatura);
+    viaturas.emplace(matricula, marca, modelo, data);
     println("");
     show_msg("Novo veiculo acrescentado com sucesso!\n");
     pause_();
@@ -295,6 +363,33 @@ void delete_viat(){
     
 }
 
+/**
+ *  Função que inicia a gravação do catálogo em segundo plano, a partir de
+ *  um snapshot; o utilizador pode continuar a usar o programa.
+ */
+void exec_save() {
+    if (gravacao.start(viaturas.snapshot(), CATALOG_PATH)) {
+        show_msg("Gravação iniciada em segundo plano.");
+    }
+    else {
+        show_msg(format("Já existe uma gravação em curso ({}%).", gravacao.progress().percentagem()));
+    }
+    pause_();
+}
+
+/**
+ *  Função que espera pela gravação em curso (se existir), mostrando o progresso.
+ */
+void wait_for_save() {
+    while (gravacao.busy()) {
+        print("\r{}A gravar ... {}%", string(DEFAULT_INDENTATION, ' '), gravacao.progress().percentagem());
+        fflush(stdout);
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+    gravacao.wait();
+    print("\r");
+}
+
 /**
  *  Função que finaliza o programa e atualiza o ficheiro com todas as
  *  atualizações feitas a coleção pelo utilizador.
@@ -302,7 +397,12 @@ void delete_viat(){
 void exec_end() {
     println("");
     show_msg("[+] A actualizar catálogo ...");
-    viaturas.to_csv("viaturas.csv");// gravar catálogo em disco
+    wait_for_save();        // gravação iniciada com 'G' que ainda esteja a decorrer
+    gravacao.start(viaturas.snapshot(), CATALOG_PATH);      // gravar catálogo em disco
+    wait_for_save();
+    if (auto erro = gravacao.last_error()) {
+        show_msg(format("[!] Erro ao gravar catálogo: {}", *erro));
+    }
     show_msg("[+] ... catálogo actualizado");
     show_msg("[+] Programa vai terminar.");
     exit(0);
@@ -318,6 +418,8 @@ void exec_menu() {
         show_msg("#################################################");
         show_msg("#                                               #");
         show_msg("#  L  - Listar catálogo                         #");
+        show_msg("#  LM - Listar por marca/modelo                 #");
+        show_msg("#  LR - Listar mais recentes                    #");
         show_msg("#  P  - Pesquisar por matricula                 #");
         show_msg("#  PM - Pesquisar por marca                     #");
         show_msg("#  PN - Pesquisar por modelo                    #");
@@ -328,6 +430,12 @@ void exec_menu() {
         show_msg("#  T  - Terminar o programa                     #");
         show_msg("#                                               #");
         show_msg("#################################################");
+        if (gravacao.busy()) {
+            show_msg(format("[gravação em curso: {}%]", gravacao.progress().percentagem()));
+        }
+        else if (auto erro = gravacao.last_error()) {
+            show_msg(format("[!] Última gravação falhou: {}", *erro));
+        }
         println("");
  
         auto opcao = ask("OPÇÃO> ");
@@ -337,6 +445,12 @@ void exec_menu() {
             exec_list_viats();
             
         }
+        else if(OPCAO == "LM" || OPCAO == "LISTAR POR MARCA"){
+           exec_list_viats_by_marca();
+        }
+        else if(OPCAO == "LR" || OPCAO == "LISTAR MAIS RECENTES"){
+           exec_list_most_recent();
+        }
         else if(OPCAO == "P" || OPCAO == "PESQUISAR POR MATRICULA"){
            exec_search_by_matricula();  
         }
@@ -350,9 +464,7 @@ void exec_menu() {
             acresc_viatura();
         }
         else if(OPCAO == "G" || OPCAO == "GUARDAR"){
-            viaturas.to_csv("viaturas.csv");
-            show_msg("Guardado com sucesso!");
-            pause_();  
+            exec_save();
         }
         else if(OPCAO == "E" || OPCAO == "ELIMINAR"){
             delete_viat();
@@ -369,7 +481,49 @@ void exec_menu() {
     }
 }
   
+/**
+ *  Função que carrega o catálogo, ignorando as linhas inválidas ou
+ *  duplicadas, e mostra um resumo das linhas rejeitadas. Como o catálogo é
+ *  regravado sem elas, as linhas rejeitadas são primeiro acrescentadas a
+ *  '<path>.rejeitadas'; se isso falhar devolve false e o catálogo não deve
+ *  ser usado.
+ */
+bool load_catalog(const string& path) {
+    ImportReport report;
+    viaturas = VehicleCollection::from_csv(path, report);
+    if (report.ok()) {
+        return true;
+    }
+ 
+    const string rejeitadas_path = path + ".rejeitadas";
+    ofstream rejeitadas(rejeitadas_path, ios::app);
+    for (const auto& erro : report.erros) {
+        rejeitadas << erro.conteudo << '\n';
+    }
+    rejeitadas.close();
+    if (!rejeitadas) {
+        show_msg(format("ERRO: não foi possível guardar as linhas rejeitadas em {}", rejeitadas_path));
+        return false;
+    }
+ 
+    println("");
+    show_msg(format("[!] {} viaturas importadas, {} linhas rejeitadas:", report.importadas, report.erros.size()));
+    const size_t MAX_ERROS_MOSTRADOS = 10;
+    for (size_t i = 0; i < report.erros.size() && i < MAX_ERROS_MOSTRADOS; i += 1) {
+        const auto& erro = report.erros[i];
+        show_msg(format("linha {}: {} -> {}", erro.linha, erro.motivo, erro.conteudo), 2 * DEFAULT_INDENTATION);
+    }
+    if (report.erros.size() > MAX_ERROS_MOSTRADOS) {
+        show_msg("...", 2 * DEFAULT_INDENTATION);
+    }
+    show_msg(format("[!] Linhas rejeitadas guardadas em {}", rejeitadas_path));
+    pause_();
+    return true;
+}
+ 
 int main() {
-    viaturas = VehicleCollection::from_csv("viaturas.csv");
+    if (!load_catalog(CATALOG_PATH)) {
+        return EXIT_FAILURE;
+    }
     exec_menu();
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <fmt/format.h>
+#include <fmt/core.h>
+
+#include "Utils.hpp"
+#include "viatura.hpp"
+#include "external_merge.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace vehicle_collection;
+
+/**
+ *  Ferramenta de linha de comando para fundir vários catálogos num só,
+ *  com memória limitada (ver external_merge.hpp).
+ *
+ *  merge_catalogs [-p recente|primeiro|ultimo] [-m max_registos] [-t tmp_dir]
+ *                 saida.csv entrada1.csv [entrada2.csv ...]
+ */
+void show_usage() {
+    println("Uso: merge_catalogs [-p recente|primeiro|ultimo] [-m max_registos] [-t tmp_dir]");
+    println("                    saida.csv entrada1.csv [entrada2.csv ...]");
+}
+
+int main(int argc, char* argv[]) {
+    MergeOptions opcoes;
+    vector<string> ficheiros;
+
+    for (int i = 1; i < argc; i += 1) {
+        string arg = argv[i];
+        if ((arg == "-p" || arg == "-m" || arg == "-t") && i + 1 < argc) {
+            string valor = argv[++i];
+            if (arg == "-p") {
+                if (valor == "recente") {
+                    opcoes.politica = MergePolicy::MAIS_RECENTE;
+                }
+                else if (valor == "primeiro") {
+                    opcoes.politica = MergePolicy::PRIMEIRO;
+                }
+                else if (valor == "ultimo") {
+                    opcoes.politica = MergePolicy::ULTIMO;
+                }
+                else {
+                    println("Política {} inválida", valor);
+                    show_usage();
+                    return 1;
+                }
+            }
+            else if (arg == "-m") {
+                if (!utils::is_digit(valor) || utils::convert<size_t>(valor) == 0) {
+                    println("Número de registos {} inválido", valor);
+                    return 1;
+                }
+                opcoes.max_registos = utils::convert<size_t>(valor);
+            }
+            else {
+                opcoes.tmp_dir = valor;
+            }
+        }
+        else {
+            ficheiros.push_back(arg);
+        }
+    }
+
+    if (ficheiros.size() < 2) {
+        show_usage();
+        return 1;
+    }
+
+    auto saida = ficheiros[0];
+    vector<string> entradas(ficheiros.begin() + 1, ficheiros.end());
+    try {
+        ExternalMerge merge(opcoes);
+        auto stats = merge.merge(entradas, saida);
+        println("[+] {} linhas lidas, {} rejeitadas, {} duplicadas descartadas",
+                stats.lidas, stats.rejeitadas, stats.duplicadas);
+        println("[+] {} viaturas gravadas em {} ({} runs temporários)",
+                stats.escritas, saida, stats.runs);
+    }
+    catch (const exception& ex) {
+        println("ERRO: {}", ex.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,745 @@
+#ifndef __PAGED_VEHICLE_COLLECTION_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __PAGED_VEHICLE_COLLECTION_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdint>
+#include <fmt/format.h>
+
+#include "viatura.hpp"
+#include "vehicle_collection.hpp"
+
+/**
+ * Modo paginado para catálogos que não cabem em memória.
+ *
+ * As viaturas vivem num ficheiro de páginas de PAGE_SIZE bytes, organizado
+ * como uma B+-tree cuja chave é a matricula (ver matricula_to_key()):
+ *
+ *   página 0        metadados: "VCPG", página raiz, nº de registos
+ *   folhas          cabeçalho + até LEAF_CAPACITY registos de tamanho fixo,
+ *                   ordenados por matricula e ligados à folha seguinte
+ *   nós internos    cabeçalho + chaves separadoras + páginas filhas
+ *
+ * O acesso às páginas passa por um BufferPool com um número fixo de frames e
+ * substituição CLOCK, pelo que a memória usada não depende do tamanho do
+ * catálogo. delete_() não reequilibra a árvore (as folhas podem ficar vazias).
+ */
+namespace vehicle_collection {
+    const std::size_t PAGE_SIZE = 4096;
+
+    /**
+     * Estatísticas de acesso ao buffer pool.
+     */
+    struct BufferStats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t writes = 0;         // páginas escritas em disco
+
+        double hit_ratio() const {
+            auto total = this->hits + this->misses;
+            return total == 0 ? 0.0 : double(this->hits) / double(total);
+        }
+    };
+
+    /**
+     * Cache de páginas de um ficheiro com 'num_frames' frames de PAGE_SIZE
+     * bytes e substituição CLOCK. Uma página obtida com fetch() fica fixa
+     * (pinned) em memória até ao unpin() correspondente.
+     */
+    class BufferPool {
+    private:
+        struct Frame {
+            std::uint32_t pagina = 0;
+            bool valida = false;
+            bool suja = false;
+            bool referenciada = false;
+            int pins = 0;
+        };
+
+        std::fstream file;
+        std::vector<char> memoria;
+        std::vector<Frame> frames;
+        std::unordered_map<std::uint32_t, std::size_t> tabela;     // página -> frame
+        std::size_t ponteiro = 0;                                   // ponteiro do CLOCK
+        std::uint32_t num_paginas_ = 0;
+        BufferStats stats_;
+
+        char* dados(std::size_t frame) {
+            return this->memoria.data() + frame * PAGE_SIZE;
+        }
+
+        void write_frame(std::size_t f) {
+            this->file.clear();
+            this->file.seekp(std::streamoff(this->frames[f].pagina) * std::streamoff(PAGE_SIZE));
+            this->file.write(this->dados(f), std::streamsize(PAGE_SIZE));
+            if (!this->file) {
+                throw std::runtime_error(fmt::format("Erro ao gravar a página {}", this->frames[f].pagina));
+            }
+            this->frames[f].suja = false;
+            this->stats_.writes += 1;
+        }
+
+        /**
+         * Escolhe um frame livre ou, pelo algoritmo CLOCK, uma vítima não fixa
+         * (gravando-a em disco se estiver suja).
+         */
+        std::size_t victim() {
+            for (std::size_t passos = 0; passos < 2 * this->frames.size(); passos += 1) {
+                auto f = this->ponteiro;
+                this->ponteiro = (this->ponteiro + 1) % this->frames.size();
+
+                auto& frame = this->frames[f];
+                if (!frame.valida) {
+                    return f;
+                }
+                if (frame.pins > 0) {
+                    continue;
+                }
+                if (frame.referenciada) {
+                    frame.referenciada = false;
+                    continue;
+                }
+                if (frame.suja) {
+                    this->write_frame(f);
+                }
+                this->tabela.erase(frame.pagina);
+                frame.valida = false;
+                this->stats_.evictions += 1;
+                return f;
+            }
+            throw std::runtime_error("BufferPool: todos os frames estão fixos");
+        }
+
+        /**
+         * Carrega 'pagina' no frame livre 'f' e fixa-a. O frame só é marcado
+         * como válido (e registado em 'tabela') depois da leitura: se esta
+         * falhar, o frame continua livre e a página não fica em cache.
+         */
+        char* load(std::size_t f, std::uint32_t pagina, bool ler) {
+            auto* buffer = this->dados(f);
+            std::memset(buffer, 0, PAGE_SIZE);
+            if (ler) {
+                this->file.clear();
+                this->file.seekg(std::streamoff(pagina) * std::streamoff(PAGE_SIZE));
+                this->file.read(buffer, std::streamsize(PAGE_SIZE));
+                if (!this->file) {
+                    throw std::runtime_error(fmt::format("Erro ao ler a página {}", pagina));
+                }
+            }
+
+            this->frames[f] = Frame{pagina, true, !ler, true, 1};
+            this->tabela[pagina] = f;
+            return buffer;
+        }
+
+    public:
+        BufferPool(const std::string& path, std::size_t num_frames)
+            : memoria(num_frames * PAGE_SIZE), frames(num_frames)
+        {
+            if (num_frames < 4) {
+                throw std::invalid_argument("BufferPool: são necessários pelo menos 4 frames");
+            }
+            if (!std::filesystem::exists(path)) {
+                std::ofstream(path, std::ios::binary);
+            }
+            this->file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+            if (!this->file) {
+                throw std::runtime_error(fmt::format("Erro ao abrir {}", path));
+            }
+            this->num_paginas_ = std::uint32_t(std::filesystem::file_size(path) / PAGE_SIZE);
+        }
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        ~BufferPool() {
+            try {
+                this->flush();
+            }
+            catch (...) {
+                // não é possível reportar erros num destrutor
+            }
+        }
+
+        std::uint32_t num_paginas() const {
+            return this->num_paginas_;
+        }
+
+        const BufferStats& stats() const {
+            return this->stats_;
+        }
+
+        /**
+         * Devolve a página fixa em memória (lendo-a do disco se necessário).
+         */
+        char* fetch(std::uint32_t pagina) {
+            if (pagina >= this->num_paginas_) {
+                throw std::out_of_range(fmt::format("Página {} inexistente", pagina));
+            }
+            auto it = this->tabela.find(pagina);
+            if (it != this->tabela.end()) {
+                auto& frame = this->frames[it->second];
+                frame.pins += 1;
+                frame.referenciada = true;
+                this->stats_.hits += 1;
+                return this->dados(it->second);
+            }
+            this->stats_.misses += 1;
+            return this->load(this->victim(), pagina, true);
+        }
+
+        /**
+         * Acrescenta uma página nova (a zeros) ao fim do ficheiro e fixa-a.
+         */
+        std::uint32_t allocate() {
+            auto pagina = this->num_paginas_++;
+            this->load(this->victim(), pagina, false);
+            return pagina;
+        }
+
+        /**
+         * Dados de uma página que já está fixa (ex: acabada de alocar).
+         */
+        char* pinned(std::uint32_t pagina) {
+            return this->dados(this->tabela.at(pagina));
+        }
+
+        void unpin(std::uint32_t pagina, bool suja) {
+            auto& frame = this->frames[this->tabela.at(pagina)];
+            frame.pins -= 1;
+            frame.suja = frame.suja || suja;
+        }
+
+        /**
+         * Grava em disco todas as páginas sujas.
+         */
+        void flush() {
+            for (std::size_t f = 0; f < this->frames.size(); f += 1) {
+                if (this->frames[f].valida && this->frames[f].suja) {
+                    this->write_frame(f);
+                }
+            }
+            this->file.flush();
+        }
+    };
+
+    /**
+     * Página fixa no buffer pool durante o tempo de vida do objecto.
+     */
+    class PageGuard {
+    private:
+        BufferPool* pool;
+        std::uint32_t pagina;
+        char* buffer;
+        bool suja = false;
+
+    public:
+        PageGuard(BufferPool& pool, std::uint32_t pagina)
+            : pool(&pool), pagina(pagina), buffer(pool.fetch(pagina))
+        {
+        }
+
+        // página nova: aloca-a no fim do ficheiro (já fica fixa)
+        struct Nova {};
+
+        PageGuard(BufferPool& pool, Nova)
+            : pool(&pool), pagina(pool.allocate()), buffer(pool.pinned(this->pagina)), suja(true)
+        {
+        }
+
+        PageGuard(const PageGuard&) = delete;
+        PageGuard& operator=(const PageGuard&) = delete;
+
+        ~PageGuard() {
+            this->pool->unpin(this->pagina, this->suja);
+        }
+
+        std::uint32_t id() const {
+            return this->pagina;
+        }
+
+        const char* data() const {
+            return this->buffer;
+        }
+
+        char* data_mut() {
+            this->suja = true;
+            return this->buffer;
+        }
+    };
+
+    /**
+     * VehicleCollection em modo paginado (ver comentário no topo do ficheiro).
+     */
+    class PagedVehicleCollection {
+    public:
+        // tamanho máximo de marca/modelo num registo de tamanho fixo
+        static constexpr std::size_t MAX_TEXTO = 54;
+
+    private:
+        enum TipoPagina : std::uint8_t {
+            FOLHA = 1,
+            INTERNA = 2
+        };
+
+        // cabeçalho das páginas da árvore: tipo (1), livre (1), nº de entradas (2), folha seguinte (4)
+        static constexpr std::size_t HEADER_SIZE = 8;
+
+        // registo: matricula (8) + data (10) + marca e modelo (1 byte de comprimento + MAX_TEXTO)
+        static constexpr std::size_t SLOT_SIZE = 8 + 10 + 2 * (1 + MAX_TEXTO);
+        static constexpr std::size_t LEAF_CAPACITY = (PAGE_SIZE - HEADER_SIZE) / SLOT_SIZE;
+
+        // nó interno: n chaves seguidas de n + 1 páginas filhas (4 bytes cada)
+        static constexpr std::size_t INTERNAL_CAPACITY = (PAGE_SIZE - HEADER_SIZE - 4) / 8;
+        static constexpr std::size_t CHILDREN_OFFSET = HEADER_SIZE + 4 * INTERNAL_CAPACITY;
+
+        static constexpr const char* MAGIC = "VCPG";
+
+        struct Split {
+            std::uint32_t chave;        // primeira chave da nova página
+            std::uint32_t pagina;
+        };
+
+        BufferPool pool;
+        std::uint32_t raiz = 1;
+        std::uint64_t num_registos = 0;
+
+        static std::uint32_t get_u32(const char* buffer, std::size_t offset) {
+            std::uint32_t valor;
+            std::memcpy(&valor, buffer + offset, sizeof(valor));
+            return valor;
+        }
+
+        static void put_u32(char* buffer, std::size_t offset, std::uint32_t valor) {
+            std::memcpy(buffer + offset, &valor, sizeof(valor));
+        }
+
+        static std::uint8_t tipo(const char* pagina) {
+            return std::uint8_t(pagina[0]);
+        }
+
+        static std::uint16_t num_entradas(const char* pagina) {
+            std::uint16_t n;
+            std::memcpy(&n, pagina + 2, sizeof(n));
+            return n;
+        }
+
+        static void set_header(char* pagina, TipoPagina tipo, std::size_t n) {
+            pagina[0] = char(tipo);
+            auto n16 = std::uint16_t(n);
+            std::memcpy(pagina + 2, &n16, sizeof(n16));
+        }
+
+        static std::uint32_t proxima_folha(const char* pagina) {
+            return get_u32(pagina, 4);
+        }
+
+        static char* slot(char* pagina, std::size_t i) {
+            return pagina + HEADER_SIZE + i * SLOT_SIZE;
+        }
+
+        static const char* slot(const char* pagina, std::size_t i) {
+            return pagina + HEADER_SIZE + i * SLOT_SIZE;
+        }
+
+        static std::uint32_t chave_slot(const char* s) {
+            return matricula_to_key(std::string(s, 8));
+        }
+
+        static std::uint32_t chave_interna(const char* pagina, std::size_t i) {
+            return get_u32(pagina, HEADER_SIZE + 4 * i);
+        }
+
+        static std::uint32_t filho(const char* pagina, std::size_t i) {
+            return get_u32(pagina, CHILDREN_OFFSET + 4 * i);
+        }
+
+        static void encode(const Viatura& viat, char* s) {
+            auto put_texto = [&s](const std::string& texto) {
+                s[0] = char(texto.size());
+                std::memcpy(s + 1, texto.data(), texto.size());
+                s += 1 + MAX_TEXTO;
+            };
+            std::memset(s, 0, SLOT_SIZE);
+            std::memcpy(s, viat.get_matricula().data(), 8);
+            std::memcpy(s + 8, viat.get_data().data(), 10);
+            s += 18;
+            put_texto(viat.get_marca());
+            put_texto(viat.get_modelo());
+        }
+
+        static Viatura decode(const char* s) {
+            auto get_texto = [s](std::size_t offset) {
+                return std::string(s + offset + 1, std::size_t(std::uint8_t(s[offset])));
+            };
+            return Viatura(
+                std::string(s, 8),
+                get_texto(18),
+                get_texto(18 + 1 + MAX_TEXTO),
+                std::string(s + 8, 10)
+            );
+        }
+
+        /**
+         * Posição da primeira entrada da folha com chave >= 'chave'.
+         */
+        static std::size_t lower_bound_folha(const char* pagina, std::uint32_t chave) {
+            std::size_t lo = 0;
+            std::size_t hi = num_entradas(pagina);
+            while (lo < hi) {
+                auto mid = (lo + hi) / 2;
+                if (chave_slot(slot(pagina, mid)) < chave) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        /**
+         * Índice do filho de um nó interno onde 'chave' deve estar.
+         */
+        static std::size_t indice_filho(const char* pagina, std::uint32_t chave) {
+            std::size_t lo = 0;
+            std::size_t hi = num_entradas(pagina);
+            while (lo < hi) {
+                auto mid = (lo + hi) / 2;
+                if (chave_interna(pagina, mid) <= chave) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        /**
+         * Desce da raiz até à folha onde 'chave' está ou deveria estar.
+         */
+        std::uint32_t find_folha(std::uint32_t chave) {
+            auto pagina = this->raiz;
+            while (true) {
+                PageGuard guard(this->pool, pagina);
+                if (tipo(guard.data()) == FOLHA) {
+                    return pagina;
+                }
+                pagina = filho(guard.data(), indice_filho(guard.data(), chave));
+            }
+        }
+
+        std::optional<Split> insert_folha(std::uint32_t pagina, std::uint32_t chave, const char* novo, bool& duplicada) {
+            PageGuard guard(this->pool, pagina);
+            auto n = num_entradas(guard.data());
+            auto pos = lower_bound_folha(guard.data(), chave);
+            if (pos < n && chave_slot(slot(guard.data(), pos)) == chave) {
+                duplicada = true;
+                return {};
+            }
+
+            auto* buffer = guard.data_mut();
+            if (n < LEAF_CAPACITY) {
+                std::memmove(slot(buffer, pos + 1), slot(buffer, pos), (n - pos) * SLOT_SIZE);
+                std::memcpy(slot(buffer, pos), novo, SLOT_SIZE);
+                set_header(buffer, FOLHA, n + 1);
+                return {};
+            }
+
+            // folha cheia: divide as n + 1 entradas entre esta folha e uma nova
+            std::vector<char> todas((n + 1) * SLOT_SIZE);
+            std::memcpy(todas.data(), slot(buffer, 0), pos * SLOT_SIZE);
+            std::memcpy(todas.data() + pos * SLOT_SIZE, novo, SLOT_SIZE);
+            std::memcpy(todas.data() + (pos + 1) * SLOT_SIZE, slot(buffer, pos), (n - pos) * SLOT_SIZE);
+
+            auto esquerda = (n + 1) / 2;
+            auto direita = n + 1 - esquerda;
+            PageGuard nova(this->pool, PageGuard::Nova{});
+            auto nova_id = nova.id();
+            auto* nova_buffer = nova.data_mut();
+
+            std::memcpy(slot(buffer, 0), todas.data(), esquerda * SLOT_SIZE);
+            set_header(buffer, FOLHA, esquerda);
+            std::memcpy(slot(nova_buffer, 0), todas.data() + esquerda * SLOT_SIZE, direita * SLOT_SIZE);
+            set_header(nova_buffer, FOLHA, direita);
+
+            put_u32(nova_buffer, 4, proxima_folha(buffer));
+            put_u32(buffer, 4, nova_id);
+            return Split{chave_slot(slot(nova_buffer, 0)), nova_id};
+        }
+
+        std::optional<Split> insert_em(std::uint32_t pagina, std::uint32_t chave, const char* novo, bool& duplicada) {
+            std::size_t i;
+            std::uint32_t destino;
+            {
+                PageGuard guard(this->pool, pagina);
+                if (tipo(guard.data()) == FOLHA) {
+                    destino = pagina;
+                    i = 0;
+                }
+                else {
+                    i = indice_filho(guard.data(), chave);
+                    destino = filho(guard.data(), i);
+                }
+            }
+            if (destino == pagina) {
+                return this->insert_folha(pagina, chave, novo, duplicada);
+            }
+
+            auto split = this->insert_em(destino, chave, novo, duplicada);
+            if (!split) {
+                return {};
+            }
+
+            // o filho 'i' dividiu-se: acrescenta a chave separadora e a nova página
+            PageGuard guard(this->pool, pagina);
+            auto* buffer = guard.data_mut();
+            auto n = num_entradas(buffer);
+            std::vector<std::uint32_t> chaves(n);
+            std::vector<std::uint32_t> filhos(n + 1);
+            for (std::size_t j = 0; j < n; j += 1) {
+                chaves[j] = chave_interna(buffer, j);
+            }
+            for (std::size_t j = 0; j <= n; j += 1) {
+                filhos[j] = filho(buffer, j);
+            }
+            chaves.insert(chaves.begin() + i, split->chave);
+            filhos.insert(filhos.begin() + i + 1, split->pagina);
+
+            auto write_interna = [](char* destino, const std::uint32_t* k, const std::uint32_t* c, std::size_t n) {
+                set_header(destino, INTERNA, n);
+                for (std::size_t j = 0; j < n; j += 1) {
+                    put_u32(destino, HEADER_SIZE + 4 * j, k[j]);
+                }
+                for (std::size_t j = 0; j <= n; j += 1) {
+                    put_u32(destino, CHILDREN_OFFSET + 4 * j, c[j]);
+                }
+            };
+
+            if (chaves.size() <= INTERNAL_CAPACITY) {
+                write_interna(buffer, chaves.data(), filhos.data(), chaves.size());
+                return {};
+            }
+
+            // nó cheio: a chave do meio sobe para o nível de cima
+            auto meio = chaves.size() / 2;
+            PageGuard nova(this->pool, PageGuard::Nova{});
+            write_interna(buffer, chaves.data(), filhos.data(), meio);
+            write_interna(
+                nova.data_mut(),
+                chaves.data() + meio + 1,
+                filhos.data() + meio + 1,
+                chaves.size() - meio - 1
+            );
+            return Split{chaves[meio], nova.id()};
+        }
+
+        void write_meta() {
+            PageGuard meta(this->pool, 0);
+            auto* buffer = meta.data_mut();
+            std::memcpy(buffer, MAGIC, 4);
+            put_u32(buffer, 4, this->raiz);
+            std::memcpy(buffer + 8, &this->num_registos, sizeof(this->num_registos));
+        }
+
+    public:
+        /**
+         * Abre (ou cria) um catálogo paginado em 'path', usando no máximo
+         * 'num_frames' páginas de memória.
+         */
+        explicit PagedVehicleCollection(const std::string& path, std::size_t num_frames = 64)
+            : pool(path, num_frames)
+        {
+            if (this->pool.num_paginas() == 0) {
+                {
+                    PageGuard meta(this->pool, PageGuard::Nova{});     // página 0
+                    PageGuard folha(this->pool, PageGuard::Nova{});
+                    set_header(folha.data_mut(), FOLHA, 0);
+                    this->raiz = folha.id();
+                }
+                this->write_meta();
+                return;
+            }
+
+            PageGuard meta(this->pool, 0);
+            if (std::memcmp(meta.data(), MAGIC, 4) != 0) {
+                throw std::runtime_error(fmt::format("{} não é um catálogo paginado", path));
+            }
+            this->raiz = get_u32(meta.data(), 4);
+            std::memcpy(&this->num_registos, meta.data() + 8, sizeof(this->num_registos));
+        }
+
+        PagedVehicleCollection(const PagedVehicleCollection&) = delete;
+        PagedVehicleCollection& operator=(const PagedVehicleCollection&) = delete;
+
+        ~PagedVehicleCollection() {
+            try {
+                this->write_meta();
+            }
+            catch (...) {
+                // não é possível reportar erros num destrutor
+            }
+        }
+
+        std::size_t size() const {
+            return std::size_t(this->num_registos);
+        }
+
+        bool empty() const {
+            return this->num_registos == 0;
+        }
+
+        const BufferStats& stats() const {
+            return this->pool.stats();
+        }
+
+        /**
+         * Grava em disco os metadados e todas as páginas alteradas.
+         */
+        void flush() {
+            this->write_meta();
+            this->pool.flush();
+        }
+
+        std::optional<Viatura> search_by_mat(const std::string& matricula) {
+            if (!Viatura::valida_matricula(matricula)) {
+                return {};
+            }
+            auto chave = matricula_to_key(matricula);
+            PageGuard folha(this->pool, this->find_folha(chave));
+            auto pos = lower_bound_folha(folha.data(), chave);
+            if (pos < num_entradas(folha.data()) && chave_slot(slot(folha.data(), pos)) == chave) {
+                return decode(slot(folha.data(), pos));
+            }
+            return {};
+        }
+
+        /**
+         * Igual a add(), mas devolve false em vez de lançar DuplicateValue.
+         * Lança InvalidAttr se marca ou modelo excederem MAX_TEXTO caracteres.
+         */
+        bool try_add(const Viatura& viat) {
+            if (viat.get_marca().size() > MAX_TEXTO || viat.get_modelo().size() > MAX_TEXTO) {
+                throw InvalidAttr(fmt::format(
+                    "Marca/modelo de {} excede {} caracteres", viat.get_matricula(), MAX_TEXTO
+                ));
+            }
+            char novo[SLOT_SIZE];
+            encode(viat, novo);
+
+            bool duplicada = false;
+            auto split = this->insert_em(this->raiz, matricula_to_key(viat.get_matricula()), novo, duplicada);
+            if (duplicada) {
+                return false;
+            }
+            if (split) {
+                // a raiz dividiu-se: nova raiz com as duas metades
+                PageGuard guard(this->pool, PageGuard::Nova{});
+                auto* buffer = guard.data_mut();
+                set_header(buffer, INTERNA, 1);
+                put_u32(buffer, HEADER_SIZE, split->chave);
+                put_u32(buffer, CHILDREN_OFFSET, this->raiz);
+                put_u32(buffer, CHILDREN_OFFSET + 4, split->pagina);
+                this->raiz = guard.id();
+            }
+            this->num_registos += 1;
+            return true;
+        }
+
+        void add(const Viatura& viat) {
+            if (!this->try_add(viat)) {
+                throw DuplicateValue(fmt::format("Matricula {} já existe", viat.get_matricula()));
+            }
+        }
+
+        bool delete_(const std::string& matricula) {
+            if (!Viatura::valida_matricula(matricula)) {
+                return false;
+            }
+            auto chave = matricula_to_key(matricula);
+            PageGuard folha(this->pool, this->find_folha(chave));
+            auto n = num_entradas(folha.data());
+            auto pos = lower_bound_folha(folha.data(), chave);
+            if (pos >= n || chave_slot(slot(folha.data(), pos)) != chave) {
+                return false;
+            }
+            auto* buffer = folha.data_mut();
+            std::memmove(slot(buffer, pos), slot(buffer, pos + 1), (n - pos - 1) * SLOT_SIZE);
+            set_header(buffer, FOLHA, n - 1);
+            this->num_registos -= 1;
+            return true;
+        }
+
+        /**
+         * Percorre todas as viaturas por ordem de matricula, folha a folha.
+         * Cada folha é descodificada e libertada antes de chamar 'funcao'.
+         */
+        template<typename F>
+        void for_each(F funcao) {
+            auto pagina = this->raiz;
+            while (true) {
+                PageGuard guard(this->pool, pagina);
+                if (tipo(guard.data()) == FOLHA) {
+                    break;
+                }
+                pagina = filho(guard.data(), 0);
+            }
+
+            std::vector<Viatura> viaturas;
+            while (pagina != 0) {
+                {
+                    PageGuard folha(this->pool, pagina);
+                    for (std::size_t i = 0; i < num_entradas(folha.data()); i += 1) {
+                        viaturas.push_back(decode(slot(folha.data(), i)));
+                    }
+                    pagina = proxima_folha(folha.data());
+                }
+                for (const auto& viat : viaturas) {
+                    funcao(viat);
+                }
+                viaturas.clear();
+            }
+        }
+
+        /**
+         * Pesquisa por predicado sobre todo o catálogo (ver for_each).
+         */
+        template<typename F>
+        VehicleCollection search(F funcao_criterio) {
+            VehicleCollection found_viaturas;
+            this->for_each([&found_viaturas, &funcao_criterio](const Viatura& viat) {
+                if (funcao_criterio(viat)) {
+                    found_viaturas.add(viat);
+                }
+            });
+            return found_viaturas;
+        }
+
+        /**
+         *  Acrescenta as viaturas de um ficheiro CSV (ver import_csv_lines),
+         *  rejeitando também as de marca/modelo com mais de MAX_TEXTO caracteres.
+         */
+        void import_csv(const std::string& path, ImportReport& report) {
+            import_csv_lines(path, report, [this](Viatura&& viat) -> std::optional<std::string> {
+                if (viat.get_marca().size() > MAX_TEXTO || viat.get_modelo().size() > MAX_TEXTO) {
+                    return "Marca/modelo demasiado longo";
+                }
+                if (!this->try_add(viat)) {
+                    return "Matricula duplicada";
+                }
+                return {};
+            });
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef __SCHEMA_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __SCHEMA_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <utility>
+#include <charconv>
+#include <type_traits>
+#include <tuple>
+
+/**
+ * Descrição em tempo de compilação de registos delimitados (ex: CSV).
+ *
+ * Um esquema é a lista ordenada dos campos de uma classe, cada um descrito
+ * por um Campo<&Classe::membro, validador, estado>, onde 'estado' é o valor
+ * (ex: um enumerado da classe) que identifica o campo quando é rejeitado. A
+ * partir dessa descrição são gerados o parser (uma só passagem, sem
+ * alocações na divisão em campos nem na validação) e o serializador.
+ *
+ *   using Esquema = schema::Esquema<'|',
+ *       schema::Campo<&Pessoa::nome, &Pessoa::valida_nome, Estado::NOME>,
+ *       schema::Campo<&Pessoa::idade, &Pessoa::valida_idade, Estado::IDADE>
+ *   >;
+ */
+namespace schema {
+    /**
+     * Conversão entre o texto de um campo e o tipo do membro. Os tipos
+     * numéricos usam std::from_chars/std::to_chars.
+     */
+    template<typename T, typename = void>
+    struct Conversor;
+
+    template<>
+    struct Conversor<std::string> {
+        static bool parse(std::string_view texto, std::string& valor) {
+            valor.assign(texto);
+            return true;
+        }
+
+        static void format(const std::string& valor, std::string& out) {
+            out.append(valor);
+        }
+    };
+
+    template<typename T>
+    struct Conversor<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+        static bool parse(std::string_view texto, T& valor) {
+            auto fim = texto.data() + texto.size();
+            auto [ptr, ec] = std::from_chars(texto.data(), fim, valor);
+            return ec == std::errc() && ptr == fim;
+        }
+
+        static void format(T valor, std::string& out) {
+            char buffer[64];
+            auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), valor);
+            out.append(buffer, ptr);
+        }
+    };
+
+    template<typename M>
+    struct MemberPointer;
+
+    template<typename C, typename T>
+    struct MemberPointer<T C::*> {
+        using Classe = C;
+        using Tipo = T;
+    };
+
+    /**
+     * Campo de um esquema: o membro onde é guardado, o validador do texto
+     * (bool(std::string_view)), aplicado antes da conversão, e o estado que
+     * identifica o campo quando é rejeitado.
+     */
+    template<auto Membro, auto Validador, auto Estado>
+    struct Campo {
+        using Classe = typename MemberPointer<decltype(Membro)>::Classe;
+        using Tipo = typename MemberPointer<decltype(Membro)>::Tipo;
+        static constexpr auto ESTADO = Estado;
+
+        static bool valida(std::string_view texto) {
+            return Validador(texto);
+        }
+
+        static bool parse(std::string_view texto, Classe& destino) {
+            return Conversor<Tipo>::parse(texto, destino.*Membro);
+        }
+
+        static void format(const Classe& origem, std::string& out) {
+            Conversor<Tipo>::format(origem.*Membro, out);
+        }
+    };
+
+    enum class Erro {
+        NENHUM,
+        NUM_CAMPOS,         // número de campos diferente do esquema
+        VALIDACAO,          // o validador do campo rejeitou o texto
+        CONVERSAO           // o texto não é convertível para o tipo do campo
+    };
+
+    struct Resultado {
+        Erro erro = Erro::NENHUM;
+        std::size_t campo = 0;      // índice do campo com erro
+
+        explicit operator bool() const {
+            return this->erro == Erro::NENHUM;
+        }
+    };
+
+    template<char Delim, typename Primeiro, typename... Restantes>
+    struct Esquema {
+        using Classe = typename Primeiro::Classe;
+        static constexpr std::size_t NUM_CAMPOS = 1 + sizeof...(Restantes);
+        using Campos = std::array<std::string_view, NUM_CAMPOS>;
+
+        // estado de cada campo (Campo::ESTADO), pela ordem do esquema; indexado
+        // por Resultado::campo
+        static constexpr std::array ESTADOS = {Primeiro::ESTADO, Restantes::ESTADO...};
+
+        /**
+         * Divide a linha nos campos (vistas sobre a própria linha, sem cópias).
+         * Falha se o número de delimitadores não corresponder ao esquema.
+         */
+        static bool tokenize(std::string_view linha, Campos& campos) {
+            std::size_t inicio = 0;
+            for (std::size_t i = 0; i < NUM_CAMPOS; i += 1) {
+                auto fim = linha.find(Delim, inicio);
+                if (i + 1 == NUM_CAMPOS) {
+                    if (fim != std::string_view::npos) {
+                        return false;
+                    }
+                    fim = linha.size();
+                }
+                else if (fim == std::string_view::npos) {
+                    return false;
+                }
+                campos[i] = linha.substr(inicio, fim - inicio);
+                inicio = fim + 1;
+            }
+            return true;
+        }
+
+        /**
+         * Valida todos os campos, devolvendo o primeiro inválido.
+         */
+        static Resultado valida(const Campos& campos) {
+            return valida(campos, std::make_index_sequence<NUM_CAMPOS>());
+        }
+
+        /**
+         * Divide, valida e converte 'linha' para 'destino'. Se a divisão ou a
+         * validação falharem, 'destino' não é alterado.
+         */
+        static Resultado parse(std::string_view linha, Classe& destino) {
+            Campos campos;
+            if (!tokenize(linha, campos)) {
+                return {Erro::NUM_CAMPOS, 0};
+            }
+            if (auto resultado = valida(campos); !resultado) {
+                return resultado;
+            }
+            return converte(campos, destino, std::make_index_sequence<NUM_CAMPOS>());
+        }
+
+        /**
+         * Acrescenta a 'out' o registo serializado (campos separados por Delim).
+         */
+        static void format(const Classe& origem, std::string& out) {
+            format(origem, out, std::make_index_sequence<NUM_CAMPOS>());
+        }
+
+    private:
+        template<std::size_t I>
+        using CampoN = std::tuple_element_t<I, std::tuple<Primeiro, Restantes...>>;
+
+        template<std::size_t... Is>
+        static Resultado valida(const Campos& campos, std::index_sequence<Is...>) {
+            Resultado resultado;
+            // pára no primeiro campo inválido (avaliação da esquerda para a direita)
+            ((CampoN<Is>::valida(campos[Is]) || (resultado = {Erro::VALIDACAO, Is}, false)) && ...);
+            return resultado;
+        }
+
+        template<std::size_t... Is>
+        static Resultado converte(const Campos& campos, Classe& destino, std::index_sequence<Is...>) {
+            Resultado resultado;
+            ((CampoN<Is>::parse(campos[Is], destino) || (resultado = {Erro::CONVERSAO, Is}, false)) && ...);
+            return resultado;
+        }
+
+        template<std::size_t... Is>
+        static void format(const Classe& origem, std::string& out, std::index_sequence<Is...>) {
+            ((Is > 0 ? out.push_back(Delim) : void(), CampoN<Is>::format(origem, out)), ...);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef __SHARDED_VEHICLE_COLLECTION_HPP__  // Verifica se o cabeçalho já foi incluído
+#define __SHARDED_VEHICLE_COLLECTION_HPP__   // Define o cabeçalho para evitar múltiplas inclusões
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <algorithm>
+#include <fmt/format.h>
+
+#include "viatura.hpp"
+#include "vehicle_collection.hpp"
+
+namespace vehicle_collection {
+    /**
+     * Coleção de viaturas particionada por hash da matricula em várias
+     * VehicleCollection independentes (shards), cada uma com o seu próprio
+     * armazenamento, índice e lock. Operações sobre matriculas diferentes
+     * podem assim decorrer em paralelo, sem lock global.
+     * Pesquisas e iteração percorrem todos os shards (fan-out).
+     */
+    class ShardedVehicleCollection {
+    private:
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            VehicleCollection viaturas;
+        };
+
+        // unique_ptr porque std::shared_mutex não pode ser movido
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        Shard& shard_de(const std::string& matricula) const {
+            return *this->shards[std::hash<std::string>{}(matricula) % this->shards.size()];
+        }
+
+    public:
+        explicit ShardedVehicleCollection(
+                std::size_t num_shards = std::max(1u, std::thread::hardware_concurrency())
+        ) {
+            if (num_shards == 0) {
+                throw std::invalid_argument("ShardedVehicleCollection: número de shards inválido");
+            }
+            for (std::size_t i = 0; i < num_shards; i += 1) {
+                this->shards.emplace_back(std::make_unique<Shard>());
+            }
+        }
+
+        std::size_t num_shards() const {
+            return this->shards.size();
+        }
+
+        /**
+         * Acrescenta uma viatura ao shard da sua matricula. Lança DuplicateValue
+         * se a matricula já existir (tal como VehicleCollection::add).
+         */
+        void add(const Viatura& viat) {
+            auto& shard = this->shard_de(viat.get_matricula());
+            std::unique_lock lock(shard.mutex);
+            shard.viaturas.add(viat);
+        }
+
+        /**
+         * Igual a add(), mas devolve false em vez de lançar DuplicateValue.
+         */
+        bool try_add(const Viatura& viat) {
+            auto& shard = this->shard_de(viat.get_matricula());
+            std::unique_lock lock(shard.mutex);
+            return shard.viaturas.try_add(viat);
+        }
+
+        bool try_add(Viatura&& viat) {
+            auto& shard = this->shard_de(viat.get_matricula());
+            std::unique_lock lock(shard.mutex);
+            return shard.viaturas.try_add(std::move(viat));
+        }
+
+        bool delete_(const std::string& matricula) {
+            auto& shard = this->shard_de(matricula);
+            std::unique_lock lock(shard.mutex);
+            return shard.viaturas.delete_(matricula);
+        }
+
+        std::optional<Viatura> search_by_mat(const std::string& matricula) const {
+            auto& shard = this->shard_de(matricula);
+            std::shared_lock lock(shard.mutex);
+            return shard.viaturas.search_by_mat(matricula);
+        }
+
+        /**
+         * Pesquisa por predicado em todos os shards; o resultado é uma única
+         * VehicleCollection com as viaturas encontradas.
+         */
+        template<typename F>
+        VehicleCollection search(F funcao_criterio) const {
+            VehicleCollection found_viaturas;
+            this->for_each([&found_viaturas, &funcao_criterio](const Viatura& viat) {
+                if (funcao_criterio(viat)) {
+                    found_viaturas.add(viat);
+                }
+            });
+            return found_viaturas;
+        }
+
+        /**
+         * Percorre todas as viaturas, shard a shard. Cada shard fica bloqueado
+         * para escrita apenas enquanto está a ser percorrido.
+         */
+        template<typename F>
+        void for_each(F funcao) const {
+            for (const auto& shard : this->shards) {
+                std::shared_lock lock(shard->mutex);
+                for (const auto& viat : shard->viaturas) {
+                    funcao(viat);
+                }
+            }
+        }
+
+        std::size_t size() const {
+            std::size_t total = 0;
+            for (const auto& shard : this->shards) {
+                std::shared_lock lock(shard->mutex);
+                total += shard->viaturas.size();
+            }
+            return total;
+        }
+
+        bool empty() const {
+            return this->size() == 0;
+        }
+
+        /**
+         * Junta todos os shards numa única VehicleCollection (ex: para gravar
+         * o catálogo com VehicleCollection::to_csv).
+         */
+        VehicleCollection to_collection() const {
+            return this->search([](const Viatura&) { return true; });
+        }
+
+        /**
+         *  Acrescenta as viaturas de um ficheiro CSV (ver import_csv_lines). A
+         *  validação decorre fora dos locks; só o shard de destino de cada
+         *  linha é bloqueado. Pode ser chamada em simultâneo por várias threads.
+         */
+        void import_csv(const std::string& path, ImportReport& report) {
+            import_csv_lines(path, report, [this](Viatura&& viat) {
+                return this->try_add(std::move(viat));
+            });
+        }
+
+        /**
+         *  Importa vários ficheiros CSV em paralelo (uma thread por ficheiro).
+         *  Devolve um relatório por ficheiro, pela mesma ordem de 'paths'.
+         *  Quando a mesma matricula aparece em mais que um ficheiro fica a
+         *  primeira a ser inserida; as restantes são reportadas como duplicadas.
+         */
+        std::vector<ImportReport> import_csv(const std::vector<std::string>& paths) {
+            std::vector<ImportReport> reports(paths.size());
+            std::vector<std::thread> threads;
+            threads.reserve(paths.size());
+            for (std::size_t i = 0; i < paths.size(); i += 1) {
+                threads.emplace_back([this, &paths, &reports, i]() {
+                    this->import_csv(paths[i], reports[i]);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            return reports;
+        }
+    };
+}
+
+#endif
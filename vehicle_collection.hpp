@@ -8,7 +8,14 @@
 #include <optional>
 #include <stdexcept>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
 #include <regex>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include <fmt/core.h>
@@ -21,16 +28,197 @@ namespace vehicle_collection {
         using std::invalid_argument::invalid_argument;
     };
 
+    /**
+     * Linha rejeitada durante uma importação em massa.
+     */
+    struct ImportError {
+        std::size_t linha;       // número da linha no ficheiro (a partir de 1)
+        std::string motivo;
+        std::string conteudo;
+    };
+
+    /**
+     * Relatório de uma importação em massa: número de registos aceites e
+     * todas as linhas rejeitadas (inválidas ou duplicadas).
+     */
+    struct ImportReport {
+        std::size_t importadas = 0;
+        std::vector<ImportError> erros;
+
+        bool ok() const {
+            return this->erros.empty();
+        }
+    };
+
+    template<typename F>
+    void import_csv_lines(const std::string& path, ImportReport& report, F insere);
+
+    /**
+     * Critérios de ordenação suportados pelas listagens ordenadas.
+     * A matricula entra sempre como critério de desempate, logo a ordem é total.
+     */
+    enum class SortKey {
+        MATRICULA,
+        MARCA_MODELO,
+        DATA
+    };
+
+    /**
+     * Chaves de pesquisa normalizadas (ver utils::normalize) de uma viatura,
+     * calculadas uma única vez na inserção.
+     */
+    struct SearchKeys {
+        std::string marca;
+        std::string modelo;
+    };
+
     class VehicleCollection {
+    public:
+        using Snapshot = std::shared_ptr<const std::vector<Viatura>>;
+
     private:
-        // atributo da classe
-        std::vector<Viatura> viaturas;
+        // atributo da classe; partilhado com os snapshots (copy-on-write)
+        std::shared_ptr<std::vector<Viatura>> registos = std::make_shared<std::vector<Viatura>>();
+
+        // índice matricula -> posição em 'registos'
+        std::unordered_map<std::string, std::size_t> posicoes;
+
+        // chaves[i] são as chaves normalizadas de viaturas()[i]; o texto
+        // original continua em 'registos' para apresentação
+        std::vector<SearchKeys> chaves;
+
+        // permutações (índices para 'registos') por critério de ordenação.
+        // Cada uma é construída na primeira listagem ordenada que a pede e a
+        // partir daí é actualizada incrementalmente em add() e delete_(), sem
+        // nunca mover os registos.
+        std::map<SortKey, std::vector<std::size_t>> ordens;
+
+        // abaixo desta fracção da coleção, top_k() usa selecção parcial em vez
+        // de construir (e guardar) a permutação completa
+        static constexpr std::size_t TOP_K_FRACCAO = 16;
+
+        // de quantas em quantas viaturas write_csv() reporta o progresso
+        static constexpr std::size_t PROGRESSO_PASSO = 1024;
+
+        const std::vector<Viatura>& viaturas() const {
+            return *this->registos;
+        }
+
+        /**
+         * Acesso para alteração: se o armazenamento estiver partilhado com
+         * algum snapshot, é copiado primeiro para que o snapshot não mude.
+         */
+        std::vector<Viatura>& viaturas_mut() {
+            if (this->registos.use_count() > 1) {
+                this->registos = std::make_shared<std::vector<Viatura>>(*this->registos);
+            }
+            else {
+                // use_count() é uma leitura relaxed e o último snapshot pode ter
+                // sido largado noutra thread (ex: AsyncSaver): a barreira
+                // garante que as leituras dessa thread terminaram antes de
+                // alterarmos os registos
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return *this->registos;
+        }
+
+        static bool menor(SortKey key, const Viatura& a, const Viatura& b) {
+            switch (key) {
+                case SortKey::MARCA_MODELO:
+                    return std::tie(a.get_marca(), a.get_modelo(), a.get_matricula())
+                         < std::tie(b.get_marca(), b.get_modelo(), b.get_matricula());
+                case SortKey::DATA:
+                    // datas em formato ISO comparam correctamente como texto
+                    return std::tie(a.get_data(), a.get_matricula())
+                         < std::tie(b.get_data(), b.get_matricula());
+                case SortKey::MATRICULA:
+                default:
+                    return a.get_matricula() < b.get_matricula();
+            }
+        }
+
+        /**
+         * Converte uma sequência de índices em ponteiros para os registos,
+         * percorrendo-a do fim para o início se 'desc' for verdadeiro.
+         */
+        template<typename It>
+        std::vector<const Viatura*> to_ptrs(It first, It last, std::size_t k, bool desc) const {
+            std::vector<const Viatura*> result;
+            result.reserve(k);
+            if (desc) {
+                for (auto it = last; it != first && result.size() < k; ) {
+                    --it;
+                    result.push_back(&this->viaturas()[*it]);
+                }
+            }
+            else {
+                for (auto it = first; it != last && result.size() < k; ++it) {
+                    result.push_back(&this->viaturas()[*it]);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Chama 'funcao' para cada viatura cuja chave normalizada é igual ao
+         * termo (ou começa por ele). O termo é normalizado uma vez; as
+         * comparações são directas.
+         */
+        template<typename F>
+        void for_each_by_key(
+                std::string SearchKeys::*campo,
+                const std::string& termo,
+                bool prefixo,
+                F funcao
+        ) const {
+            const auto norm = utils::normalize(termo);
+            for (std::size_t i = 0; i < this->viaturas().size(); i += 1) {
+                const auto& chave = this->chaves[i].*campo;
+                if (prefixo ? chave.starts_with(norm) : chave == norm) {
+                    funcao(this->viaturas()[i]);
+                }
+            }
+        }
+
+        /**
+         * Inserção comum a try_add(const Viatura&) e try_add(Viatura&&).
+         */
+        template<typename V>
+        bool insert(V&& viat) {
+            auto [it, inserida] = this->posicoes.try_emplace(viat.get_matricula(), this->viaturas().size());
+            if (!inserida) {
+                return false;
+            }
+            this->chaves.push_back({utils::normalize(viat.get_marca()), utils::normalize(viat.get_modelo())});
+            this->viaturas_mut().emplace_back(std::forward<V>(viat));
+
+            // insere o novo índice na posição certa de cada permutação já existente
+            const auto novo = this->viaturas().size() - 1;
+            for (auto& [key, idx] : this->ordens) {
+                auto pos = std::upper_bound(idx.begin(), idx.end(), novo,
+                    [this, key = key](std::size_t i, std::size_t j) {
+                        return menor(key, this->viaturas()[i], this->viaturas()[j]);
+                    }
+                );
+                idx.insert(pos, novo);
+            }
+            return true;
+        }
     
     public:
-        std::vector<Viatura> get_collection() {
-            return this->viaturas;
+        /**
+         *  Linhas vazias ou de comentário ('##' ou '//') são ignoradas na leitura
+         *  de ficheiros CSV. Remove os espaços à direita e esquerda de 'line'.
+         */
+        static bool linha_ignorada(std::string& line) {
+            return utils::trim(line).empty() || line.find("##") == 0 || line.find("//") == 0;
+        }
+
+        const std::vector<Viatura>& get_collection() const {
+            return this->viaturas();
         }
 
+
         /**
          *  Função que cria um objeto da Classe VehicleCollection
          *  e atribui dados(Viaturas) a partir de um ficheiro CSV.
@@ -41,60 +229,145 @@ namespace vehicle_collection {
             std::ifstream csv_file(path);
             std::string line;
             while (std::getline(csv_file, line)) {
-                //se após remoção dos espaços a direita e esquerda
-                // a string estiver vazia
-                if (utils::trim(line).empty()) {
+                if (linha_ignorada(line)) {
                     continue; //pula para próxima linha
                 }
-    
-                if (line.find("##") == 0 || line.find("//") == 0) {
-                    continue;
-                }
                 viaturas.add(Viatura::from_csv(line));
             }
             return viaturas;
         }
 
+        /**
+         *  Variante de from_csv para importação em massa: não aborta na primeira
+         *  linha inválida. As linhas válidas são acrescentadas à coleção e as
+         *  inválidas ou duplicadas ficam registadas em 'report'.
+         */
+        static VehicleCollection from_csv(const std::string& path, ImportReport& report) {
+            VehicleCollection viaturas;
+            viaturas.import_csv(path, report);
+            return viaturas;
+        }
+
+        /**
+         *  Acrescenta à coleção as viaturas de um ficheiro CSV numa só passagem,
+         *  sem excepções no caminho de rejeição (ver ImportReport).
+         */
+        void import_csv(const std::string& path, ImportReport& report) {
+            import_csv_lines(path, report, [this](Viatura&& viat) {
+                return this->try_add(std::move(viat));
+            });
+        }
+
         /**
          * Função que subscreve linha a linha convertendo cada elem(Viatura) da
          * coleção em  formato CSV, adicionando uma quebra de linha ao fim de cada elemento
          * da coleção, enquando esse não for o último.
          */
-        void to_csv(const std::string& path) {
+        void to_csv(const std::string& path) const {
+            write_csv(this->viaturas(), path, [](std::size_t) {});
+            fmt::println("");     
+        }
+
+        /**
+         * Grava em CSV um conjunto de viaturas (ex: um snapshot), chamando
+         * 'progresso(n)' a cada PROGRESSO_PASSO viaturas e no fim, com o
+         * número de viaturas já gravadas.
+         */
+        template<typename F>
+        static void write_csv(const std::vector<Viatura>& viaturas, const std::string& path, F progresso) {
             std::ofstream csv_file;
             csv_file.open(path);
    
+            std::string linha;      // reutilizado entre viaturas
             for (std::size_t i = 0; i < viaturas.size(); i += 1) {
-                csv_file << viaturas[i].to_csv();
+                linha.clear();
+                viaturas[i].to_csv(linha);
    
                 if (i < viaturas.size() - 1) {
-                    csv_file << '\n';
+                    linha.push_back('\n');
+                }
+                csv_file.write(linha.data(), std::streamsize(linha.size()));
+                if ((i + 1) % PROGRESSO_PASSO == 0) {
+                    progresso(i + 1);
                 }
             }
-            fmt::println("");     
+            csv_file.close();
+            if (!csv_file) {
+                throw std::runtime_error(fmt::format("Erro ao gravar {}", path));
+            }
+            progresso(viaturas.size());
+        }
+
+        /**
+         * Cópia consistente (point-in-time) das viaturas, em O(1): partilha o
+         * armazenamento com a coleção, que passa a copiá-lo antes da próxima
+         * alteração (copy-on-write). Pode ser lida noutra thread.
+         */
+        Snapshot snapshot() const {
+            return this->registos;
         }
      
         /**
         * Função que verfica se uma matrícula já existe na coleção
         */
-        std::optional<Viatura> search_by_mat(const std::string& matricula) {
-            for (const auto& mat : this->viaturas) {
-                if (mat.get_matricula() == matricula) {
-                    return mat;
-                }
+        std::optional<Viatura> search_by_mat(const std::string& matricula) const {
+            if (auto viat = this->find_by_mat(matricula)) {
+                return *viat;
             }
             return {};
         }
 
+        /**
+         * Igual a search_by_mat, mas sem cópia: devolve um ponteiro para a
+         * viatura na coleção (ou nullptr), válido até ao próximo add()/delete_().
+         */
+        const Viatura* find_by_mat(const std::string& matricula) const {
+            auto it = this->posicoes.find(matricula);
+            if (it != this->posicoes.end()) {
+                return &this->viaturas()[it->second];
+            }
+            return nullptr;
+        }
+
         /**
          * Função que recebe uma viatura e adiciona à coleção, mas antes verifica se já existe
          * se existir, uma exceção é lançada.
          */
         void add(const Viatura& viat) {
-            if (this->search_by_mat(viat.get_matricula())) {
+            if (!this->try_add(viat)) {
+                throw DuplicateValue(fmt::format("Matricula {} já existe", viat.get_matricula()));
+            }
+        }
+
+        /**
+         * Versão de add() que move a viatura para a coleção em vez de a copiar.
+         */
+        void add(Viatura&& viat) {
+            if (this->posicoes.contains(viat.get_matricula())) {
                 throw DuplicateValue(fmt::format("Matricula {} já existe", viat.get_matricula()));
             }
-            this->viaturas.emplace_back(viat);
+            this->insert(std::move(viat));
+        }
+
+        /**
+         * Constrói a viatura a partir dos atributos (com a validação habitual
+         * de Viatura) e acrescenta-a à coleção sem cópias intermédias.
+         */
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            this->add(Viatura(std::forward<Args>(args)...));
+        }
+
+        /**
+         * Igual a add(), mas em vez de lançar DuplicateValue devolve false
+         * quando a matricula já existe na coleção.
+         */
+        bool try_add(const Viatura& viat) {
+            return this->insert(viat);
+        }
+
+        bool try_add(Viatura&& viat) {
+            return this->insert(std::move(viat));
         }
 
         /**
@@ -102,14 +375,34 @@ namespace vehicle_collection {
          * a matricula fornecida for encontrada.
          */
         bool delete_(const std::string& matricula) {
-            for (std::size_t i = 0; i < viaturas.size(); i++) {
-                if (matricula == viaturas[i].get_matricula()) {
-                    //viaturas[i].mostra();
-                    viaturas.erase(viaturas.begin() + i);
-                    return true;
+            auto encontrada = this->posicoes.find(matricula);
+            if (encontrada == this->posicoes.end()) {
+                return false;
+            }
+
+            const auto i = encontrada->second;
+            auto& mut = this->viaturas_mut();
+            mut.erase(mut.begin() + i);
+            chaves.erase(chaves.begin() + i);
+
+            // corrige as posições das viaturas que estavam depois da removida
+            this->posicoes.erase(encontrada);
+            for (auto& [mat, pos] : this->posicoes) {
+                if (pos > i) {
+                    pos -= 1;
+                }
+            }
+
+            // retira o índice removido das permutações e corrige os restantes
+            for (auto& [key, idx] : this->ordens) {
+                idx.erase(std::remove(idx.begin(), idx.end(), i), idx.end());
+                for (auto& j : idx) {
+                    if (j > i) {
+                        j -= 1;
+                    }
                 }
             }
-            return false;
+            return true;
         }
     
         /**
@@ -118,7 +411,7 @@ namespace vehicle_collection {
         template<typename F>
         VehicleCollection search(F funcao_criterio) const {
             VehicleCollection found_viaturas;
-            for (const auto& viat : this->viaturas) {
+            for (const auto& viat : this->viaturas()) {
                 if (funcao_criterio(viat)) {
                     found_viaturas.add(viat);
                 }
@@ -127,24 +420,162 @@ namespace vehicle_collection {
         }
     
         /**
-         * sintaxe para transformar a colecão de objetos iterável
+         * Pesquisa por marca sem distinguir maiúsculas/minúsculas nem espaços
+         * repetidos. Com 'prefixo' devolve as marcas que começam pelo termo.
+         */
+        VehicleCollection search_by_marca(const std::string& marca, bool prefixo = false) const {
+            VehicleCollection found_viaturas;
+            this->for_each_by_marca(marca, prefixo, [&found_viaturas](const Viatura& viat) {
+                found_viaturas.add(viat);
+            });
+            return found_viaturas;
+        }
+
+        /**
+         * Igual a search_by_marca, mas para o modelo.
+         */
+        VehicleCollection search_by_modelo(const std::string& modelo, bool prefixo = false) const {
+            VehicleCollection found_viaturas;
+            this->for_each_by_modelo(modelo, prefixo, [&found_viaturas](const Viatura& viat) {
+                found_viaturas.add(viat);
+            });
+            return found_viaturas;
+        }
+
+        /**
+         * Variantes de search_by_marca/search_by_modelo sem cópias: em vez de
+         * construir uma nova coleção, chamam 'funcao' para cada viatura encontrada.
+         */
+        template<typename F>
+        void for_each_by_marca(const std::string& marca, bool prefixo, F funcao) const {
+            this->for_each_by_key(&SearchKeys::marca, marca, prefixo, funcao);
+        }
+
+        template<typename F>
+        void for_each_by_modelo(const std::string& modelo, bool prefixo, F funcao) const {
+            this->for_each_by_key(&SearchKeys::modelo, modelo, prefixo, funcao);
+        }
+
+        /**
+         * Devolve a permutação (índices na coleção) ordenada pelo critério
+         * indicado. Na primeira chamada para cada critério a permutação é
+         * calculada; nas seguintes é devolvida a cópia mantida pela coleção.
+         */
+        const std::vector<std::size_t>& ordem(SortKey key) {
+            auto it = this->ordens.find(key);
+            if (it == this->ordens.end()) {
+                std::vector<std::size_t> idx(this->viaturas().size());
+                std::iota(idx.begin(), idx.end(), 0);
+                std::sort(idx.begin(), idx.end(), [this, key](std::size_t i, std::size_t j) {
+                    return menor(key, this->viaturas()[i], this->viaturas()[j]);
+                });
+                it = this->ordens.emplace(key, std::move(idx)).first;
+            }
+            return it->second;
+        }
+
+        /**
+         * Listagem ordenada de toda a coleção. Devolve ponteiros para os registos
+         * (que não são copiados nem movidos); ficam inválidos após add()/delete_().
          */
-        std::vector<Viatura>::iterator begin() {
-            return this->viaturas.begin();
+        std::vector<const Viatura*> ordered(SortKey key, bool desc = false) {
+            const auto& idx = this->ordem(key);
+            return this->to_ptrs(idx.begin(), idx.end(), idx.size(), desc);
+        }
+
+        /**
+         * Devolve os primeiros 'k' registos segundo o critério indicado
+         * (ex: top_k(SortKey::DATA, 100, true) -> as 100 viaturas mais recentes).
+         * Se a permutação já existir é usada directamente; para 'k' pequeno
+         * faz-se uma selecção parcial sem construir a permutação completa.
+         */
+        std::vector<const Viatura*> top_k(SortKey key, std::size_t k, bool desc = false) {
+            k = std::min(k, this->viaturas().size());
+
+            auto it = this->ordens.find(key);
+            if (it == this->ordens.end() && k <= this->viaturas().size() / TOP_K_FRACCAO) {
+                std::vector<std::size_t> idx(this->viaturas().size());
+                std::iota(idx.begin(), idx.end(), 0);
+                std::partial_sort(idx.begin(), idx.begin() + k, idx.end(),
+                    [this, key, desc](std::size_t i, std::size_t j) {
+                        return desc ? menor(key, this->viaturas()[j], this->viaturas()[i])
+                                    : menor(key, this->viaturas()[i], this->viaturas()[j]);
+                    }
+                );
+                return this->to_ptrs(idx.begin(), idx.begin() + k, k, false);
+            }
+
+            const auto& idx = this->ordem(key);
+            return this->to_ptrs(idx.begin(), idx.end(), k, desc);
+        }
+
+        /**
+         * sintaxe para transformar a colecão de objetos iterável.
+         * A iteração é só de leitura: alterar uma viatura no lugar deixaria
+         * desactualizados o índice, as chaves de pesquisa e as permutações.
+         */
+        std::vector<Viatura>::const_iterator begin() const {
+            return this->viaturas().begin();
         }
     
-        std::vector<Viatura>::iterator end() {
-            return this->viaturas.end();
+        std::vector<Viatura>::const_iterator end() const {
+            return this->viaturas().end();
         }
     
         std::size_t size() const {
-            return this->viaturas.size();
+            return this->viaturas().size();
         }
     
         bool empty() const {
-            return this->viaturas.empty();
+            return this->viaturas().empty();
         }
     };
+
+    /**
+     *  Leitura comum às importações em massa (VehicleCollection,
+     *  ShardedVehicleCollection, PagedVehicleCollection): lê 'path' linha a
+     *  linha, ignora as linhas de VehicleCollection::linha_ignorada, valida
+     *  com Viatura::try_from_csv e passa cada viatura válida a 'insere'.
+     *  'insere' devolve bool (false: matricula duplicada) ou
+     *  std::optional<std::string> com o motivo da rejeição.
+     */
+    template<typename F>
+    void import_csv_lines(const std::string& path, ImportReport& report, F insere) {
+        std::ifstream csv_file(path);
+        std::string line;
+        std::size_t num_linha = 0;
+        std::optional<Viatura> viat;
+        while (std::getline(csv_file, line)) {
+            num_linha += 1;
+            if (VehicleCollection::linha_ignorada(line)) {
+                continue;
+            }
+
+            viat.reset();
+            auto status = Viatura::try_from_csv(line, viat);
+            if (status != ParseStatus::OK) {
+                report.erros.push_back({num_linha, to_string(status), line});
+                continue;
+            }
+
+            std::optional<std::string> motivo;
+            if constexpr (std::is_same_v<decltype(insere(std::move(*viat))), bool>) {
+                if (!insere(std::move(*viat))) {
+                    motivo = "Matricula duplicada";
+                }
+            }
+            else {
+                motivo = insere(std::move(*viat));
+            }
+
+            if (motivo) {
+                report.erros.push_back({num_linha, std::move(*motivo), line});
+            }
+            else {
+                report.importadas += 1;
+            }
+        }
+    }
 }
 
 #endif
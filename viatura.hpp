@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <fstream>
 #include <vector>
 #include <optional>
@@ -13,23 +15,51 @@
 #include <fmt/ranges.h>
 #include <fmt/core.h>
 #include <cstdlib>
+#include <cstdint>
  
 #include "Utils.hpp"
+#include "schema.hpp"
  
-const std::string CSV_DELIM = "|";
+constexpr char CSV_DELIM_CHAR = '|';
+const std::string CSV_DELIM(1, CSV_DELIM_CHAR);
 
 namespace vehicle_collection { 
     class InvalidAttr : public std::invalid_argument {
         using std::invalid_argument::invalid_argument; // herda construtores da classe invalid_argument
     };
+
+    /**
+     * Resultado da validação de um registo, usado nos caminhos que não lançam
+     * excepções (ex: importação em massa).
+     */
+    enum class ParseStatus {
+        OK,
+        NUM_ATRIBUTOS,
+        MATRICULA,
+        MARCA,
+        MODELO,
+        DATA
+    };
+
+    inline std::string to_string(ParseStatus status) {
+        switch (status) {
+            case ParseStatus::OK:            return "OK";
+            case ParseStatus::NUM_ATRIBUTOS: return "Número de atributos inválidos";
+            case ParseStatus::MATRICULA:     return "Matricula inválida";
+            case ParseStatus::MARCA:         return "Marca inválida";
+            case ParseStatus::MODELO:        return "Modelo inválido";
+            case ParseStatus::DATA:          return "Data inválida";
+        }
+        return "Erro desconhecido";
+    }
   
     class Viatura {
     public:
         Viatura(
-                const std::string& matricula,        // matricula: DD-LL-DD onde D: Dígito L: Letra
-                const std::string& marca,            // deve ter uma ou mais palavras (apenas letras ou dígitos)
-                const std::string& modelo,           // mesmo que a marca
-                const std::string& data              // deve vir no formato ISO: 'YYYY-MM-DD'
+                std::string matricula,        // matricula: DD-LL-DD onde D: Dígito L: Letra
+                std::string marca,            // deve ter uma ou mais palavras (apenas letras ou dígitos)
+                std::string modelo,           // mesmo que a marca
+                std::string data              // deve vir no formato ISO: 'YYYY-MM-DD'
         ) {
             // 1. Validar parâmetros
             if (!this->valida_matricula(matricula)) {
@@ -49,44 +79,89 @@ namespace vehicle_collection {
             }
     
             // 2. Associar parâmetros a atributos (ie, construir a representação)
-            //    interna do objecto)
-            this->matricula = matricula;
-            this->marca = marca;
-            this->modelo = modelo;
-            this->data = data;
+            //    interna do objecto); os parâmetros são recebidos por valor e
+            //    movidos, para que quem passa temporários não pague cópias
+            this->matricula = std::move(matricula);
+            this->marca = std::move(marca);
+            this->modelo = std::move(modelo);
+            this->data = std::move(data);
         }
     
         Viatura(
-                const std::string& matricula,
-                const std::string& marca,
-                const std::string& modelo
-        ) : Viatura(matricula, marca, modelo, "2020-01-01")
+                std::string matricula,
+                std::string marca,
+                std::string modelo
+        ) : Viatura(std::move(matricula), std::move(marca), std::move(modelo), "2020-01-01")
         {
         }
+
+        /**
+         * Valida os atributos de uma viatura sem lançar excepções, devolvendo
+         * o primeiro atributo inválido (ou ParseStatus::OK).
+         */
+        static ParseStatus valida(
+                std::string_view matricula,
+                std::string_view marca,
+                std::string_view modelo,
+                std::string_view data
+        ) {
+            if (!valida_matricula(matricula)) {
+                return ParseStatus::MATRICULA;
+            }
+            if (!valida_marca(marca)) {
+                return ParseStatus::MARCA;
+            }
+            if (!valida_modelo(modelo)) {
+                return ParseStatus::MODELO;
+            }
+            if (!valida_data(data)) {
+                return ParseStatus::DATA;
+            }
+            return ParseStatus::OK;
+        }
+
+        /**
+         * Versão de from_csv que não lança excepções: em caso de sucesso
+         * preenche 'viat' e devolve ParseStatus::OK, caso contrário devolve
+         * o motivo da rejeição e deixa 'viat' inalterado.
+         */
+        static ParseStatus try_from_csv(std::string_view viat_csv, std::optional<Viatura>& viat) {
+            Viatura nova{SemValidacao{}};
+            auto status = status_de(Esquema::parse(viat_csv, nova));
+            if (status == ParseStatus::OK) {
+                viat.emplace(std::move(nova));
+            }
+            return status;
+        }
     
-        static Viatura from_csv(const std::string& viat_csv) {
-            auto attrs = utils::split(viat_csv, CSV_DELIM);
-            if (attrs.size() != 4) {
+        static Viatura from_csv(std::string_view viat_csv) {
+            Viatura viat{SemValidacao{}};
+            auto resultado = Esquema::parse(viat_csv, viat);
+            if (resultado.erro == schema::Erro::NUM_CAMPOS) {
                 throw InvalidAttr("from_csv: Número de atributos inválidos");
             }
-            return Viatura(
-                attrs[0],       // matricula
-                attrs[1],       // marca
-                attrs[2],       // modelo
-                attrs[3]        // data
-            );
+            if (!resultado) {
+                Esquema::Campos campos;
+                Esquema::tokenize(viat_csv, campos);
+                throw InvalidAttr(fmt::format(
+                    "from_csv: {}: {}", to_string(status_de(resultado)), campos[resultado.campo]
+                ));
+            }
+            return viat;
         }
     
-        std::string to_csv() {
-            return utils::join(
-                {
-                    this->matricula,
-                    this->marca,
-                    this->modelo,
-                    this->data
-                },
-                CSV_DELIM
-            );
+        std::string to_csv() const {
+            std::string csv;
+            this->to_csv(csv);
+            return csv;
+        }
+
+        /**
+         * Acrescenta a 'out' a viatura em formato CSV (permite reutilizar o
+         * mesmo buffer ao gravar muitas viaturas).
+         */
+        void to_csv(std::string& out) const {
+            Esquema::format(*this, out);
         }
     
         void mostra() const {
@@ -96,44 +171,54 @@ namespace vehicle_collection {
             );
         }
     
-        static bool valida_matricula(const std::string& matricula) {
-            return std::regex_match(matricula, std::regex("^[0-9]{2}-[A-Z]{2}-[0-9]{2}$"));
+        // validadores sobre std::string_view, sem alocações nem expressões
+        // regulares (usados também pelo Esquema)
+        static bool valida_matricula(std::string_view matricula) {
+            // ^[0-9]{2}-[A-Z]{2}-[0-9]{2}$
+            auto digito = [](char ch) { return ch >= '0' && ch <= '9'; };
+            auto letra = [](char ch) { return ch >= 'A' && ch <= 'Z'; };
+            return matricula.size() == 8
+                && digito(matricula[0]) && digito(matricula[1]) && matricula[2] == '-'
+                && letra(matricula[3]) && letra(matricula[4]) && matricula[5] == '-'
+                && digito(matricula[6]) && digito(matricula[7])
+            ;
         }
     
-        static bool valida_marca(const std::string& marca) {
-            // return regex_match(marca, regex("^([A-Z0-9]+)+$"));
-    
-            // uma ou mais palavras, cada palavra apenas deve conter digitos/letras
-            auto palavras = utils::split(marca);
-            for (const auto& palavra : palavras) {
-                if (!utils::is_alnum(palavra)) {
+        static bool valida_marca(std::string_view marca) {
+            // uma ou mais palavras separadas por espaços/tabs/mudanças de linha,
+            // cada palavra apenas deve conter digitos/letras
+            bool tem_palavra = false;
+            for (auto ch : marca) {
+                if (ch == ' ' || ch == '\t' || ch == '\n') {
+                    continue;
+                }
+                bool alnum = (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9');
+                if (!alnum) {
                     return false;
                 }
+                tem_palavra = true;
             }
-            return palavras.size() > 0;
+            return tem_palavra;
         }
     
-        static bool valida_modelo(const std::string& modelo) {
+        static bool valida_modelo(std::string_view modelo) {
             return valida_marca(modelo);
         }
     
-        static bool valida_data(const std::string& data) {
-            // return regex_match(data, regex("^\\d{4}-\\d{2}-\\d{2}$"));
-            auto date_parts = utils::split(data, "-");
-            if (date_parts.size() != 3) {
+        static bool valida_data(std::string_view data) {
+            // ^[0-9]{4}-[0-9]{2}-[0-9]{2}$
+            if (data.size() != 10 || data[4] != '-' || data[7] != '-') {
                 return false;
             }
-            auto year = date_parts[0];
-            auto month = date_parts[1];
-            auto day = date_parts[2];
-    
-            return    year.size() == 4 && utils::is_digit(year)
-                && month.size() == 2 && utils::is_digit(month)
-                && day.size() == 2 && utils::is_digit(day)
-            ;
+            for (std::size_t i = 0; i < data.size(); i += 1) {
+                if (i != 4 && i != 7 && (data[i] < '0' || data[i] > '9')) {
+                    return false;
+                }
+            }
+            return true;
         }
     
-        std::string get_matricula() const {
+        const std::string& get_matricula() const {
             return this->matricula;
         }
     
@@ -144,15 +229,15 @@ namespace vehicle_collection {
             this->matricula = nova_matricula;
         }
     
-        std::string get_marca() const {
+        const std::string& get_marca() const {
             return this->marca;
         }
     
-        std::string get_modelo() const {
+        const std::string& get_modelo() const {
             return this->modelo;
         }
     
-        std::string get_data() const {
+        const std::string& get_data() const {
             return this->data;
         }
     
@@ -164,16 +249,80 @@ namespace vehicle_collection {
         }
     
         int get_ano() const {
-            auto ano_str = utils::split(this->data, "-")[0];
-            return utils::convert<int>(ano_str);
+            int ano = 0;
+            std::from_chars(this->data.data(), this->data.data() + 4, ano);
+            return ano;
         }
     
     private:
+        struct SemValidacao {};
+
+        // viatura vazia, a preencher (e validar) por Esquema::parse
+        explicit Viatura(SemValidacao) {}
+
         std::string matricula;
         std::string marca;
         std::string modelo;
         std::string data;
+
+        // esquema do registo CSV: ordem dos campos, delimitador, validadores
+        // e motivo de rejeição de cada campo
+        using Esquema = schema::Esquema<CSV_DELIM_CHAR,
+            schema::Campo<&Viatura::matricula, &Viatura::valida_matricula, ParseStatus::MATRICULA>,
+            schema::Campo<&Viatura::marca, &Viatura::valida_marca, ParseStatus::MARCA>,
+            schema::Campo<&Viatura::modelo, &Viatura::valida_modelo, ParseStatus::MODELO>,
+            schema::Campo<&Viatura::data, &Viatura::valida_data, ParseStatus::DATA>
+        >;
+
+        static ParseStatus status_de(const schema::Resultado& resultado) {
+            switch (resultado.erro) {
+                case schema::Erro::NENHUM:
+                    return ParseStatus::OK;
+                case schema::Erro::NUM_CAMPOS:
+                    return ParseStatus::NUM_ATRIBUTOS;
+                default:
+                    return Esquema::ESTADOS[resultado.campo];
+            }
+        }
     };
 
+    /**
+     * Converte uma matricula válida (DD-LL-DD) num inteiro que preserva a
+     * ordem lexicográfica das matriculas (usado nos formatos binários).
+     */
+    inline std::uint32_t matricula_to_key(const std::string& matricula) {
+        auto d = [&matricula](std::size_t i) { return std::uint32_t(matricula[i] - '0'); };
+        auto l = [&matricula](std::size_t i) { return std::uint32_t(matricula[i] - 'A'); };
+        return ((d(0) * 10 + d(1)) * 26 * 26 + l(3) * 26 + l(4)) * 100 + d(6) * 10 + d(7);
+    }
+
+    inline std::string key_to_matricula(std::uint32_t key) {
+        std::string matricula = "00-AA-00";
+        matricula[7] = char('0' + key % 10); key /= 10;
+        matricula[6] = char('0' + key % 10); key /= 10;
+        matricula[4] = char('A' + key % 26); key /= 26;
+        matricula[3] = char('A' + key % 26); key /= 26;
+        matricula[1] = char('0' + key % 10); key /= 10;
+        matricula[0] = char('0' + key % 10);
+        return matricula;
+    }
+
+    /**
+     * Converte uma data válida (YYYY-MM-DD) no inteiro YYYYMMDD e vice-versa.
+     */
+    inline std::uint32_t data_to_int(const std::string& data) {
+        std::uint32_t valor = 0;
+        for (auto ch : data) {
+            if (ch != '-') {
+                valor = valor * 10 + std::uint32_t(ch - '0');
+            }
+        }
+        return valor;
+    }
+
+    inline std::string int_to_data(std::uint32_t valor) {
+        return fmt::format("{:04}-{:02}-{:02}", valor / 10000, valor / 100 % 100, valor % 100);
+    }
+
 }
 #endif